@@ -0,0 +1,108 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#define BENCHMARK_THREAD_LOCAL __declspec(thread)
+#define BENCHMARK_ALLOCATION_SIZE _msize
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define BENCHMARK_THREAD_LOCAL __thread
+#define BENCHMARK_ALLOCATION_SIZE malloc_size
+#else
+#include <malloc.h>
+#define BENCHMARK_THREAD_LOCAL __thread
+#define BENCHMARK_ALLOCATION_SIZE malloc_usable_size
+#endif
+
+#include "Benchmark.h"
+
+// Replaces the global operator new to count allocations per thread. This is
+// kept apart from the harness so that the compiler doesn't see through it.
+
+namespace
+{
+  BENCHMARK_THREAD_LOCAL int64_t threadAllocations = 0;
+  BENCHMARK_THREAD_LOCAL int64_t threadAllocatedBytes = 0;
+
+  std::atomic<bool> processCountingEnabled(false);
+  std::atomic<int64_t> processAllocations(0);
+  std::atomic<int64_t> processLiveBytes(0);
+}
+
+void Benchmark::EnableProcessAllocationCounting(bool enable)
+{
+  processCountingEnabled = enable;
+}
+
+Benchmark::ProcessAllocationCount Benchmark::GetProcessAllocationCount()
+{
+  ProcessAllocationCount result;
+  result.allocations = processAllocations;
+  result.liveBytes = processLiveBytes;
+  return result;
+}
+
+Benchmark::AllocationCount Benchmark::GetAllocationCount()
+{
+  AllocationCount result;
+  result.allocations = threadAllocations;
+  result.bytes = threadAllocatedBytes;
+  return result;
+}
+
+void* operator new(std::size_t size)
+{
+  threadAllocations++;
+  threadAllocatedBytes += size;
+  void* result = std::malloc(size ? size : 1);
+  if (!result)
+    throw std::bad_alloc();
+  if (processCountingEnabled.load(std::memory_order_relaxed))
+  {
+    processAllocations.fetch_add(1, std::memory_order_relaxed);
+    processLiveBytes.fetch_add(BENCHMARK_ALLOCATION_SIZE(result),
+        std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* pointer) throw()
+{
+  // Freeing memory allocated while counting was off still subtracts it, so
+  // measurements should cover the whole lifetime of the objects involved.
+  if (pointer && processCountingEnabled.load(std::memory_order_relaxed))
+  {
+    processLiveBytes.fetch_sub(BENCHMARK_ALLOCATION_SIZE(pointer),
+        std::memory_order_relaxed);
+  }
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) throw()
+{
+  std::free(pointer);
+}
@@ -0,0 +1,42 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_BASE_BENCHMARK_H
+#define ADBLOCK_PLUS_BASE_BENCHMARK_H
+
+#include <AdblockPlus.h>
+#include "Benchmark.h"
+
+class NullLogSystem : public AdblockPlus::LogSystem
+{
+public:
+  void operator()(LogLevel logLevel, const std::string& message,
+        const std::string& source)
+  {
+  }
+};
+
+inline AdblockPlus::JsEnginePtr CreateBenchmarkJsEngine(
+    const AdblockPlus::ScopedV8IsolatePtr& isolate = AdblockPlus::ScopedV8IsolatePtr())
+{
+  AdblockPlus::JsEnginePtr jsEngine =
+    AdblockPlus::JsEngine::New(AdblockPlus::AppInfo(), isolate);
+  jsEngine->SetLogSystem(AdblockPlus::LogSystemPtr(new NullLogSystem));
+  return jsEngine;
+}
+
+#endif
@@ -0,0 +1,392 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "Benchmark.h"
+#include "../src/Thread.h"
+
+using namespace Benchmark;
+
+namespace
+{
+  std::vector<Registration*>& GetRegistrations()
+  {
+    static std::vector<Registration*> registrations;
+    return registrations;
+  }
+
+  struct Result
+  {
+    int64_t iterations;
+    Clock::duration measuredTime;
+    AllocationCount allocations;
+    int64_t itemsProcessed;
+    std::map<std::string, double> counters;
+    std::string label;
+    std::vector<int64_t> latencies;
+  };
+
+  class BenchmarkThread : public AdblockPlus::Thread
+  {
+  public:
+    BenchmarkThread(Function function, State& state)
+      : function(function), state(state)
+    {
+    }
+
+    void Run()
+    {
+      function(state);
+    }
+
+  private:
+    Function function;
+    State& state;
+  };
+
+  Result RunOnce(const Registration& registration, int64_t iterations,
+                 int64_t arg, int threads)
+  {
+    std::vector<State> states;
+    for (int i = 0; i < threads; i++)
+      states.push_back(State(iterations, arg, i, threads));
+
+    if (threads == 1)
+      registration.function(states.front());
+    else
+    {
+      std::vector<BenchmarkThread*> workers;
+      for (int i = 0; i < threads; i++)
+        workers.push_back(new BenchmarkThread(registration.function, states[i]));
+      for (size_t i = 0; i < workers.size(); i++)
+        workers[i]->Start();
+      for (size_t i = 0; i < workers.size(); i++)
+      {
+        workers[i]->Join();
+        delete workers[i];
+      }
+    }
+
+    Result result;
+    result.iterations = iterations;
+    result.measuredTime = Clock::duration::zero();
+    result.allocations.allocations = 0;
+    result.allocations.bytes = 0;
+    result.itemsProcessed = 0;
+    for (std::vector<State>::const_iterator it = states.begin();
+         it != states.end(); ++it)
+    {
+      result.measuredTime = std::max(result.measuredTime, it->GetElapsed());
+      result.allocations.allocations += it->GetAllocations().allocations;
+      result.allocations.bytes += it->GetAllocations().bytes;
+      result.itemsProcessed += it->GetItemsProcessed();
+      for (std::map<std::string, double>::const_iterator counter =
+           it->GetCounters().begin(); counter != it->GetCounters().end();
+           ++counter)
+      {
+        result.counters[counter->first] += counter->second;
+      }
+      if (!it->GetLabel().empty())
+        result.label = it->GetLabel();
+      result.latencies.insert(result.latencies.end(),
+          it->GetLatencies().begin(), it->GetLatencies().end());
+    }
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+  }
+
+  Result Run(const Registration& registration, int64_t arg, int threads,
+             double minTime)
+  {
+    if (registration.iterations > 0)
+      return RunOnce(registration, registration.iterations, arg, threads);
+
+    int64_t iterations = 1;
+    while (true)
+    {
+      Result result = RunOnce(registration, iterations, arg, threads);
+      const double seconds =
+        std::chrono::duration<double>(result.measuredTime).count();
+      if (seconds >= minTime || iterations >= 1000000000)
+        return result;
+
+      // Aim for the minimum time with some headroom, but grow by at least 2x
+      // and at most 10x per attempt.
+      double multiplier = seconds > 0 ? minTime * 1.4 / seconds : 10;
+      multiplier = std::max(2.0, std::min(10.0, multiplier));
+      iterations = static_cast<int64_t>(iterations * multiplier);
+    }
+  }
+
+  std::string FormatName(const Registration& registration, int64_t arg,
+                         bool hasArg, int threads)
+  {
+    std::stringstream name;
+    name << registration.name;
+    if (hasArg)
+      name << "/" << arg;
+    if (threads > 1 || registration.threads.size() > 1)
+      name << "/threads:" << threads;
+    return name.str();
+  }
+
+  void PrintResult(const std::string& name, const Result& result,
+                   int threads)
+  {
+    const double seconds =
+      std::chrono::duration<double>(result.measuredTime).count();
+    const double nanoseconds = seconds * 1e9 / result.iterations;
+    const int64_t totalIterations = result.iterations * threads;
+
+    std::cout << std::left << std::setw(48) << name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(1)
+              << nanoseconds << " ns"
+              << std::setw(12) << result.iterations
+              << std::setw(12) << std::setprecision(2)
+              << static_cast<double>(result.allocations.allocations) /
+                 totalIterations
+              << std::setw(12) << std::setprecision(1)
+              << static_cast<double>(result.allocations.bytes) /
+                 totalIterations;
+    if (seconds > 0)
+    {
+      std::cout << std::setw(14) << std::setprecision(0)
+                << result.itemsProcessed / seconds << "/s";
+    }
+    for (std::map<std::string, double>::const_iterator it =
+         result.counters.begin(); it != result.counters.end(); ++it)
+    {
+      std::cout << "  " << it->first << "=" << std::setprecision(2)
+                << it->second;
+    }
+    if (!result.latencies.empty())
+    {
+      std::cout << std::setprecision(2)
+                << "  p50=" << Percentile(result.latencies, 50) << "us"
+                << " p99=" << Percentile(result.latencies, 99) << "us"
+                << " p999=" << Percentile(result.latencies, 99.9) << "us";
+    }
+    if (!result.label.empty())
+      std::cout << "  " << result.label;
+    std::cout << std::endl;
+  }
+}
+
+State::State(int64_t maxIterations, int64_t arg, int threadIndex, int threads)
+  : maxIterations(maxIterations), arg(arg), threadIndex(threadIndex),
+    threads(threads), iterations(0), started(false), running(false),
+    elapsed(Clock::duration::zero()), itemsProcessed(-1)
+{
+  startAllocations.allocations = startAllocations.bytes = 0;
+  allocations.allocations = allocations.bytes = 0;
+}
+
+bool State::KeepRunning()
+{
+  if (!started)
+  {
+    started = true;
+    ResumeTiming();
+  }
+  if (iterations < maxIterations)
+  {
+    iterations++;
+    return true;
+  }
+  PauseTiming();
+  return false;
+}
+
+void State::PauseTiming()
+{
+  if (!running)
+    return;
+  elapsed += Clock::now() - start;
+  AllocationCount now = GetAllocationCount();
+  allocations.allocations += now.allocations - startAllocations.allocations;
+  allocations.bytes += now.bytes - startAllocations.bytes;
+  running = false;
+}
+
+void State::ResumeTiming()
+{
+  if (running)
+    return;
+  running = true;
+  startAllocations = GetAllocationCount();
+  start = Clock::now();
+}
+
+void State::SetItemsProcessed(int64_t items)
+{
+  itemsProcessed = items;
+}
+
+int64_t State::GetItemsProcessed() const
+{
+  return itemsProcessed >= 0 ? itemsProcessed : iterations;
+}
+
+void State::SetCounter(const std::string& name, double value)
+{
+  counters[name] = value;
+}
+
+void State::SetLabel(const std::string& label)
+{
+  this->label = label;
+}
+
+void State::RecordLatency(Clock::duration latency)
+{
+  // Reserve up front so that recording doesn't distort the allocation
+  // counts.
+  if (latencies.empty())
+  {
+    PauseTiming();
+    latencies.reserve(static_cast<size_t>(std::min<int64_t>(maxIterations, 1 << 20)));
+    ResumeTiming();
+  }
+  latencies.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+}
+
+Registration::Registration(const std::string& name, Function function)
+  : name(name), function(function), iterations(0)
+{
+}
+
+Registration* Registration::Arg(int64_t arg)
+{
+  args.push_back(arg);
+  return this;
+}
+
+Registration* Registration::Range(int64_t start, int64_t limit)
+{
+  for (int64_t arg = start; arg < limit; arg *= 8)
+    args.push_back(arg);
+  args.push_back(limit);
+  return this;
+}
+
+Registration* Registration::Threads(int threads)
+{
+  this->threads.push_back(threads);
+  return this;
+}
+
+Registration* Registration::ThreadRange(int minThreads, int maxThreads)
+{
+  for (int threads = minThreads; threads < maxThreads; threads *= 2)
+    this->threads.push_back(threads);
+  this->threads.push_back(maxThreads);
+  return this;
+}
+
+Registration* Registration::Iterations(int64_t iterations)
+{
+  this->iterations = iterations;
+  return this;
+}
+
+double Benchmark::Percentile(const std::vector<int64_t>& latencies,
+                             double percentile)
+{
+  // Nearest rank
+  size_t rank = static_cast<size_t>(percentile / 100 * latencies.size());
+  rank = std::min(rank, latencies.size() - 1);
+  return latencies[rank] / 1000.0;
+}
+
+Registration* Benchmark::Register(const std::string& name, Function function)
+{
+  Registration* registration = new Registration(name, function);
+  GetRegistrations().push_back(registration);
+  return registration;
+}
+
+int Benchmark::RunBenchmarks(const std::string& filter, double minTime)
+{
+  std::cout << std::left << std::setw(48) << "Benchmark" << std::right
+            << std::setw(17) << "Time"
+            << std::setw(12) << "Iterations"
+            << std::setw(12) << "Allocs/op"
+            << std::setw(12) << "Bytes/op"
+            << std::setw(16) << "Items"
+            << std::endl;
+  std::cout << std::string(117, '-') << std::endl;
+
+  const std::vector<Registration*>& registrations = GetRegistrations();
+  int count = 0;
+  for (std::vector<Registration*>::const_iterator it = registrations.begin();
+       it != registrations.end(); ++it)
+  {
+    const Registration& registration = **it;
+    if (registration.name.find(filter) == std::string::npos)
+      continue;
+
+    const bool hasArgs = !registration.args.empty();
+    const std::vector<int64_t> args =
+      hasArgs ? registration.args : std::vector<int64_t>(1, 0);
+    const std::vector<int> threads = registration.threads.empty() ?
+      std::vector<int>(1, 1) : registration.threads;
+    for (size_t i = 0; i < args.size(); i++)
+    {
+      for (size_t j = 0; j < threads.size(); j++)
+      {
+        Result result = Run(registration, args[i], threads[j], minTime);
+        PrintResult(FormatName(registration, args[i], hasArgs, threads[j]),
+            result, threads[j]);
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string filter;
+  double minTime = 0.5;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg(argv[i]);
+    if (arg.find("--filter=") == 0)
+      filter = arg.substr(9);
+    else if (arg.find("--min-time=") == 0)
+      minTime = std::atof(arg.substr(11).c_str());
+    else
+    {
+      std::cerr << "Usage: " << argv[0]
+                << " [--filter=SUBSTRING] [--min-time=SECONDS]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (!RunBenchmarks(filter, minTime))
+  {
+    std::cerr << "No benchmark matches '" << filter << "'" << std::endl;
+    return 1;
+  }
+  return 0;
+}
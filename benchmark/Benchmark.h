@@ -0,0 +1,243 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_BENCHMARK_H
+#define ADBLOCK_PLUS_BENCHMARK_H
+
+#include <chrono>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal benchmark harness, modelled after Google Benchmark.
+ * A benchmark is a function taking a `Benchmark::State`, registered via
+ * `BENCHMARK()`:
+ *
+ *     void StringCopy(Benchmark::State& state)
+ *     {
+ *       std::string x(state.Arg(), 'x');
+ *       while (state.KeepRunning())
+ *         std::string copy(x);
+ *     }
+ *     BENCHMARK(StringCopy)->Arg(8)->Arg(1024);
+ */
+namespace Benchmark
+{
+  typedef std::chrono::high_resolution_clock Clock;
+
+  /**
+   * Allocation counters of the calling thread, only counting operator new.
+   */
+  struct AllocationCount
+  {
+    int64_t allocations;
+    int64_t bytes;
+  };
+
+  AllocationCount GetAllocationCount();
+
+  /**
+   * Allocation counters of all threads, only updated while enabled via
+   * `EnableProcessAllocationCounting()`.
+   */
+  struct ProcessAllocationCount
+  {
+    int64_t allocations;
+    /// Bytes allocated and not freed yet, including allocator overhead.
+    int64_t liveBytes;
+  };
+
+  /**
+   * Turns counting allocations of all threads on or off. This is off by
+   * default since it makes concurrent allocations contend.
+   */
+  void EnableProcessAllocationCounting(bool enable);
+
+  ProcessAllocationCount GetProcessAllocationCount();
+
+  class State
+  {
+  public:
+    State(int64_t maxIterations, int64_t arg, int threadIndex, int threads);
+
+    /**
+     * Returns `true` as long as the benchmark should keep iterating.
+     * Timing starts with the first call.
+     */
+    bool KeepRunning();
+
+    /**
+     * Excludes the following code from timing and allocation counting, use
+     * this for per-iteration setup.
+     */
+    void PauseTiming();
+    void ResumeTiming();
+
+    int64_t Arg() const
+    {
+      return arg;
+    }
+
+    int ThreadIndex() const
+    {
+      return threadIndex;
+    }
+
+    int Threads() const
+    {
+      return threads;
+    }
+
+    int64_t Iterations() const
+    {
+      return iterations;
+    }
+
+    /**
+     * Sets the number of items processed by this thread, reported as a rate.
+     * Defaults to the number of iterations.
+     */
+    void SetItemsProcessed(int64_t items);
+
+    /**
+     * Reports an additional value, summed up over all threads.
+     */
+    void SetCounter(const std::string& name, double value);
+
+    /**
+     * Attaches a free text label to the results.
+     */
+    void SetLabel(const std::string& label);
+
+    /**
+     * Records the duration of a single operation. If a benchmark records
+     * latencies, the 50th, 99th and 99.9th percentiles over all threads are
+     * reported along with the average time.
+     */
+    void RecordLatency(Clock::duration latency);
+
+    Clock::duration GetElapsed() const
+    {
+      return elapsed;
+    }
+
+    AllocationCount GetAllocations() const
+    {
+      return allocations;
+    }
+
+    int64_t GetItemsProcessed() const;
+
+    const std::map<std::string, double>& GetCounters() const
+    {
+      return counters;
+    }
+
+    const std::string& GetLabel() const
+    {
+      return label;
+    }
+
+    const std::vector<int64_t>& GetLatencies() const
+    {
+      return latencies;
+    }
+
+  private:
+    const int64_t maxIterations;
+    const int64_t arg;
+    const int threadIndex;
+    const int threads;
+    int64_t iterations;
+    bool started;
+    bool running;
+    Clock::time_point start;
+    Clock::duration elapsed;
+    AllocationCount startAllocations;
+    AllocationCount allocations;
+    int64_t itemsProcessed;
+    std::map<std::string, double> counters;
+    std::string label;
+    std::vector<int64_t> latencies;
+  };
+
+  typedef void (*Function)(State& state);
+
+  class Registration
+  {
+  public:
+    Registration(const std::string& name, Function function);
+
+    /**
+     * Runs the benchmark once per argument, see `State::Arg()`.
+     */
+    Registration* Arg(int64_t arg);
+
+    /**
+     * Runs the benchmark once per argument, going from `start` to `limit`
+     * in multiples of eight.
+     */
+    Registration* Range(int64_t start, int64_t limit);
+
+    /**
+     * Runs the benchmark function concurrently on `threads` threads.
+     */
+    Registration* Threads(int threads);
+
+    /**
+     * Runs the benchmark with `1, 2, 4, ..., maxThreads` threads.
+     */
+    Registration* ThreadRange(int minThreads, int maxThreads);
+
+    /**
+     * Uses a fixed number of iterations instead of running until the minimum
+     * time is reached, for benchmarks doing expensive setup.
+     */
+    Registration* Iterations(int64_t iterations);
+
+    const std::string name;
+    const Function function;
+    std::vector<int64_t> args;
+    std::vector<int> threads;
+    int64_t iterations;
+  };
+
+  Registration* Register(const std::string& name, Function function);
+
+  /**
+   * Returns a percentile of latencies recorded in nanoseconds, in
+   * microseconds.
+   * @param latencies Latencies in ascending order, must not be empty.
+   * @param percentile Percentile between `0` and `100`.
+   */
+  double Percentile(const std::vector<int64_t>& latencies, double percentile);
+
+  /**
+   * Runs all registered benchmarks whose name contains `filter`.
+   */
+  int RunBenchmarks(const std::string& filter, double minTime);
+}
+
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_(a, b)
+#define BENCHMARK_CONCAT_(a, b) a##b
+#define BENCHMARK(function) \
+  static Benchmark::Registration* BENCHMARK_CONCAT(registration_, __LINE__) = \
+    Benchmark::Register(#function, function)
+
+#endif
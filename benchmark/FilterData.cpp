@@ -0,0 +1,411 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "FilterData.h"
+
+using namespace FilterData;
+using AdblockPlus::Filter;
+using AdblockPlus::FilterEngine;
+
+const std::string FilterData::easyListUrl =
+  "https://easylist-downloads.adblockplus.org/easylist.txt";
+const std::string FilterData::easyPrivacyUrl =
+  "https://easylist-downloads.adblockplus.org/easyprivacy.txt";
+
+namespace
+{
+  // Filter counts of EasyList and EasyPrivacy as of 2015.
+  const int easyListSize = 50000;
+  const int easyPrivacySize = 12000;
+
+  // Indexes of different seeds don't overlap, see GenerateFilterList().
+  const int seedIndexOffset = 10000000;
+
+  // Timestamps in seconds, written so that subscriptions are never expired.
+  const char* lastDownload = "1420070400";
+  const char* expires = "4102444800";
+
+  // EasyList's mix of filter types, in percent.
+  Filter::Type GetFilterType(int index)
+  {
+    const int percent = index % 100;
+    if (percent < 45)
+      return Filter::TYPE_BLOCKING;
+    if (percent < 52)
+      return Filter::TYPE_EXCEPTION;
+    if (percent < 97)
+      return Filter::TYPE_ELEMHIDE;
+    if (percent < 98)
+      return Filter::TYPE_ELEMHIDE_EXCEPTION;
+    return Filter::TYPE_COMMENT;
+  }
+
+  std::string GetDataPath(const std::string& name)
+  {
+    const char* dataDir = std::getenv("BENCHMARK_DATA_DIR");
+    if (!dataDir || !*dataDir)
+      return "";
+    return std::string(dataDir) + "/" + name;
+  }
+
+  void StripCarriageReturn(std::string& line)
+  {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+  }
+}
+
+Corpus::Corpus(const std::vector<Request>& requests)
+  : requests(requests)
+{
+  for (size_t i = 0; i < requests.size(); i++)
+    documentUrls.push_back(std::vector<std::string>(1, requests[i].documentUrl));
+}
+
+std::string FilterData::GenerateFilter(Filter::Type type, int index)
+{
+  std::stringstream filter;
+  switch (type)
+  {
+    case Filter::TYPE_BLOCKING:
+      switch (index % 6)
+      {
+        case 0:
+          filter << "||ads" << index << ".example" << index % 97 << ".com^";
+          break;
+        case 1:
+          filter << "||track" << index << ".net^$third-party";
+          break;
+        case 2:
+          filter << "/banner" << index << "/*";
+          break;
+        case 3:
+          filter << "&adslot" << index << "=";
+          break;
+        case 4:
+          filter << ".com/ads/" << index << "/$script,domain=site"
+                 << index % 100 << ".com";
+          break;
+        default:
+          filter << "-ad-" << index << "-$image,third-party";
+          break;
+      }
+      break;
+    case Filter::TYPE_EXCEPTION:
+      if (index % 2)
+        filter << "@@||site" << index % 100 << ".com/ads/" << index << "/$script";
+      else
+        filter << "@@||cdn" << index << ".example.com^$image";
+      break;
+    case Filter::TYPE_ELEMHIDE:
+      switch (index % 3)
+      {
+        case 0:
+          filter << "##.ad-" << index;
+          break;
+        case 1:
+          filter << "site" << index % 100 << ".com###banner-" << index;
+          break;
+        default:
+          filter << "##div[id^=\"sponsor" << index << "\"]";
+          break;
+      }
+      break;
+    case Filter::TYPE_ELEMHIDE_EXCEPTION:
+      filter << "site" << index % 100 << ".com#@#.ad-" << index;
+      break;
+    case Filter::TYPE_COMMENT:
+      filter << "! Section " << index;
+      break;
+    default:
+      filter << "||invalid" << index << "^$no-such-option";
+      break;
+  }
+  return filter.str();
+}
+
+FilterList FilterData::GenerateFilterList(int filterCount, int seed)
+{
+  FilterList filters;
+  filters.reserve(filterCount);
+  for (int i = 0; i < filterCount; i++)
+  {
+    const int index = seed * seedIndexOffset + i;
+    filters.push_back(GenerateFilter(GetFilterType(i), index));
+  }
+  return filters;
+}
+
+std::vector<Request> FilterData::GenerateRequests(int requestCount)
+{
+  // minstd_rand is fully specified by the standard, unlike the
+  // distributions, so the same requests are generated everywhere.
+  std::minstd_rand random(42);
+  std::vector<Request> requests;
+  requests.reserve(requestCount);
+  for (int i = 0; i < requestCount; i++)
+  {
+    const int site = random() % 100;
+    const int index = random() % 10000;
+    std::stringstream documentUrl;
+    documentUrl << "http://site" << site << ".com/";
+
+    // Half the requests are shaped like the generated filters, whether they
+    // match depends on the type of the filter with the same index.
+    std::stringstream url;
+    FilterEngine::ContentType contentType = FilterEngine::CONTENT_TYPE_IMAGE;
+    if (random() % 2)
+    {
+      switch (index % 6)
+      {
+        case 0:
+          url << "http://ads" << index << ".example" << index % 97
+              << ".com/img.png";
+          break;
+        case 1:
+          url << "http://track" << index << ".net/pixel.gif?id=" << random();
+          break;
+        case 2:
+          url << "http://cdn.site" << site << ".com/banner" << index
+              << "/top.jpg";
+          break;
+        case 3:
+          url << "http://site" << site << ".com/serve?x=1&adslot" << index
+              << "=top";
+          contentType = FilterEngine::CONTENT_TYPE_SCRIPT;
+          break;
+        case 4:
+          url << "http://static.site" << index % 100 << ".com/ads/" << index
+              << "/loader.js";
+          documentUrl.str("");
+          documentUrl << "http://site" << index % 100 << ".com/";
+          contentType = FilterEngine::CONTENT_TYPE_SCRIPT;
+          break;
+        default:
+          url << "http://img.adserver" << site << ".com/x-ad-" << index << "-y.png";
+          break;
+      }
+    }
+    else
+    {
+      switch (index % 4)
+      {
+        case 0:
+          url << "http://site" << site << ".com/static/" << index << "/app.js";
+          contentType = FilterEngine::CONTENT_TYPE_SCRIPT;
+          break;
+        case 1:
+          url << "http://site" << site << ".com/style" << index << ".css";
+          contentType = FilterEngine::CONTENT_TYPE_STYLESHEET;
+          break;
+        case 2:
+          url << "http://video.site" << site << ".com/embed/" << index;
+          contentType = FilterEngine::CONTENT_TYPE_SUBDOCUMENT;
+          break;
+        default:
+          url << "http://cdn" << index << ".example.com/photo.jpg";
+          break;
+      }
+    }
+
+    Request request;
+    request.url = url.str();
+    request.contentType = contentType;
+    request.documentUrl = documentUrl.str();
+    requests.push_back(request);
+  }
+  return requests;
+}
+
+FilterList FilterData::LoadFilterList(const std::string& name,
+                                      int filterCount, int seed)
+{
+  const std::string path = GetDataPath(name);
+  if (path.empty())
+    return GenerateFilterList(filterCount, seed);
+
+  std::ifstream file(path.c_str());
+  if (!file)
+    throw std::runtime_error("Failed to read " + path);
+  FilterList filters;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    StripCarriageReturn(line);
+    // Skip the [Adblock Plus 2.0] header
+    if (!line.empty() && line[0] != '[')
+      filters.push_back(line);
+  }
+  return filters;
+}
+
+std::vector<Request> FilterData::LoadRequests(int requestCount)
+{
+  const std::string path = GetDataPath("requests.txt");
+  if (path.empty())
+    return GenerateRequests(requestCount);
+
+  std::ifstream file(path.c_str());
+  if (!file)
+    throw std::runtime_error("Failed to read " + path);
+  std::vector<Request> requests;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    StripCarriageReturn(line);
+    std::stringstream fields(line);
+    std::string contentType;
+    Request request;
+    if (fields >> request.url >> contentType >> request.documentUrl)
+    {
+      request.contentType = FilterEngine::StringToContentType(contentType);
+      requests.push_back(request);
+    }
+  }
+  if (requests.empty())
+    throw std::runtime_error("No requests found in " + path);
+  return requests;
+}
+
+std::string FilterData::FormatFilterList(const FilterList& filters,
+                                         int version)
+{
+  std::stringstream list;
+  list << "[Adblock Plus 2.0]\n! Version: " << version
+       << "\n! Expires: 1 days\n";
+  for (FilterList::const_iterator it = filters.begin(); it != filters.end();
+       ++it)
+  {
+    list << *it << "\n";
+  }
+  return list.str();
+}
+
+void FixtureFileSystem::AddSubscription(const std::string& url,
+                                        const FilterList& filters)
+{
+  std::stringstream section;
+  if (patterns.empty())
+    section << "# Adblock Plus preferences\nversion=4\n";
+  section << "\n[Subscription]\nurl=" << url
+          << "\ntitle=" << url
+          << "\ndownloadStatus=synchronize_ok"
+          << "\nlastDownload=" << lastDownload
+          << "\nlastSuccess=" << lastDownload
+          << "\nlastCheck=" << lastDownload
+          << "\nexpires=" << expires
+          << "\nsoftExpiration=" << expires
+          << "\n\n[Subscription filters]\n";
+  for (FilterList::const_iterator it = filters.begin(); it != filters.end();
+       ++it)
+  {
+    // Escape brackets like FilterStorage does, they would start a new section
+    std::string::size_type start = 0;
+    std::string::size_type bracket;
+    while ((bracket = it->find('[', start)) != std::string::npos)
+    {
+      section << it->substr(start, bracket - start) << "\\[";
+      start = bracket + 1;
+    }
+    section << it->substr(start) << "\n";
+  }
+  patterns += section.str();
+}
+
+std::shared_ptr<std::istream> FixtureFileSystem::Read(
+    const std::string& path) const
+{
+  std::string content;
+  if (path == "patterns.ini")
+    content = patterns;
+  else if (path == "prefs.json")
+    content = "{}";
+  return std::shared_ptr<std::istream>(new std::istringstream(content));
+}
+
+void FixtureFileSystem::Write(const std::string& path,
+                              std::shared_ptr<std::istream> content)
+{
+}
+
+void FixtureFileSystem::Move(const std::string& fromPath,
+                             const std::string& toPath)
+{
+}
+
+void FixtureFileSystem::Remove(const std::string& path)
+{
+}
+
+AdblockPlus::FileSystem::StatResult FixtureFileSystem::Stat(
+    const std::string& path) const
+{
+  StatResult result;
+  if (path == "patterns.ini" || path == "prefs.json")
+  {
+    result.exists = true;
+    result.isFile = true;
+  }
+  return result;
+}
+
+std::string FixtureFileSystem::Resolve(const std::string& path) const
+{
+  return path;
+}
+
+AdblockPlus::ServerResponse NullWebRequest::GET(const std::string& url,
+    const AdblockPlus::HeaderList& requestHeaders) const
+{
+  AdblockPlus::ServerResponse result;
+  result.status = NS_ERROR_FAILURE;
+  result.responseStatus = 0;
+  return result;
+}
+
+AdblockPlus::FileSystemPtr FilterData::CreateFileSystem(
+    const FilterList& filters)
+{
+  FixtureFileSystem* fileSystem = new FixtureFileSystem;
+  fileSystem->AddSubscription(easyListUrl, filters);
+  return AdblockPlus::FileSystemPtr(fileSystem);
+}
+
+std::unique_ptr<FilterEngine> FilterData::CreateFilterEngine(
+    const AdblockPlus::JsEnginePtr& jsEngine,
+    const AdblockPlus::FileSystemPtr& fileSystem)
+{
+  jsEngine->SetFileSystem(fileSystem);
+  jsEngine->SetWebRequest(AdblockPlus::WebRequestPtr(new NullWebRequest));
+  return std::unique_ptr<FilterEngine>(new FilterEngine(jsEngine));
+}
+
+std::unique_ptr<FilterEngine> FilterData::CreateFilterEngine(
+    const AdblockPlus::JsEnginePtr& jsEngine)
+{
+  FixtureFileSystem* fileSystem = new FixtureFileSystem;
+  fileSystem->AddSubscription(easyListUrl,
+      LoadFilterList("easylist.txt", easyListSize, 0));
+  fileSystem->AddSubscription(easyPrivacyUrl,
+      LoadFilterList("easyprivacy.txt", easyPrivacySize, 1));
+  return CreateFilterEngine(jsEngine, AdblockPlus::FileSystemPtr(fileSystem));
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_FILTER_DATA_H
+#define ADBLOCK_PLUS_FILTER_DATA_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <AdblockPlus.h>
+
+/**
+ * Filter lists and requests for the matching benchmarks.
+ *
+ * If the environment variable `BENCHMARK_DATA_DIR` is set, filter lists
+ * and the request corpus are read from files in that directory, see
+ * LoadFilterList() and LoadRequests(). Otherwise, deterministic synthetic
+ * data of the same size and shape is generated, so that results can be
+ * reproduced offline.
+ */
+namespace FilterData
+{
+  extern const std::string easyListUrl;
+  extern const std::string easyPrivacyUrl;
+
+  struct Request
+  {
+    std::string url;
+    AdblockPlus::FilterEngine::ContentType contentType;
+    std::string documentUrl;
+  };
+
+  typedef std::vector<std::string> FilterList;
+
+  /**
+   * Requests along with the document URL lists FilterEngine::Matches()
+   * expects, so that these don't have to be created while matching.
+   */
+  struct Corpus
+  {
+    explicit Corpus(const std::vector<Request>& requests);
+
+    const std::vector<Request> requests;
+    std::vector<std::vector<std::string> > documentUrls;
+  };
+
+  /**
+   * Generates a filter resembling the ones in EasyList.
+   * @param type Type of the filter.
+   * @param index Filters with different indexes are different.
+   */
+  std::string GenerateFilter(AdblockPlus::Filter::Type type, int index);
+
+  /**
+   * Generates a filter list with EasyList's mix of filter types.
+   * @param filterCount Number of filters.
+   * @param seed Lists with different seeds share no filters.
+   */
+  FilterList GenerateFilterList(int filterCount, int seed);
+
+  /**
+   * Generates requests of which roughly a fifth is blocked by lists
+   * from GenerateFilterList() with seed `0`.
+   */
+  std::vector<Request> GenerateRequests(int requestCount);
+
+  /**
+   * Reads `name` from `BENCHMARK_DATA_DIR`, in the format of a downloaded
+   * filter list. Falls back to GenerateFilterList().
+   */
+  FilterList LoadFilterList(const std::string& name, int filterCount,
+                            int seed);
+
+  /**
+   * Reads `requests.txt` from `BENCHMARK_DATA_DIR`, with one
+   * `url content-type document-url` triple per line. Falls back to
+   * GenerateRequests(). Throws if the file contains no requests.
+   */
+  std::vector<Request> LoadRequests(int requestCount);
+
+  /**
+   * Returns the complete text of a downloaded filter list.
+   */
+  std::string FormatFilterList(const FilterList& filters, int version);
+
+  /**
+   * File system serving a `patterns.ini` with the supplied subscriptions
+   * from memory. Writes are discarded.
+   */
+  class FixtureFileSystem : public AdblockPlus::FileSystem
+  {
+  public:
+    /**
+     * Adds a subscription that is up to date, so that it isn't downloaded.
+     */
+    void AddSubscription(const std::string& url, const FilterList& filters);
+
+    std::shared_ptr<std::istream> Read(const std::string& path) const;
+    void Write(const std::string& path, std::shared_ptr<std::istream> content);
+    void Move(const std::string& fromPath, const std::string& toPath);
+    void Remove(const std::string& path);
+    StatResult Stat(const std::string& path) const;
+    std::string Resolve(const std::string& path) const;
+
+  private:
+    std::string patterns;
+  };
+
+  /**
+   * Web request failing all requests, there is no network in benchmarks.
+   */
+  class NullWebRequest : public AdblockPlus::WebRequest
+  {
+  public:
+    AdblockPlus::ServerResponse GET(const std::string& url,
+        const AdblockPlus::HeaderList& requestHeaders) const;
+  };
+
+  /**
+   * Creates a file system with a single subscription containing `filters`.
+   */
+  AdblockPlus::FileSystemPtr CreateFileSystem(const FilterList& filters);
+
+  /**
+   * Creates a `FilterEngine` loading its filters from `fileSystem`.
+   */
+  std::unique_ptr<AdblockPlus::FilterEngine> CreateFilterEngine(
+      const AdblockPlus::JsEnginePtr& jsEngine,
+      const AdblockPlus::FileSystemPtr& fileSystem);
+
+  /**
+   * Creates a `FilterEngine` with EasyList and EasyPrivacy sized
+   * subscriptions, see LoadFilterList().
+   */
+  std::unique_ptr<AdblockPlus::FilterEngine> CreateFilterEngine(
+      const AdblockPlus::JsEnginePtr& jsEngine);
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+
+#include "BaseBenchmark.h"
+#include "../src/JsContext.h"
+
+namespace
+{
+  // Shared by all threads of the contention benchmarks, created by the
+  // first thread getting there. Never destroyed: V8 is shut down by a
+  // static destructor that could run first.
+  std::mutex sharedJsEngineMutex;
+  AdblockPlus::JsEnginePtr* sharedJsEngine = nullptr;
+  AdblockPlus::JsValuePtr* sharedObject = nullptr;
+
+  AdblockPlus::JsEnginePtr GetSharedJsEngine()
+  {
+    std::lock_guard<std::mutex> lock(sharedJsEngineMutex);
+    if (!sharedJsEngine)
+    {
+      sharedJsEngine = new AdblockPlus::JsEnginePtr(CreateBenchmarkJsEngine());
+      sharedObject = new AdblockPlus::JsValuePtr(
+          (*sharedJsEngine)->Evaluate("({text: '||example.com^'})"));
+    }
+    return *sharedJsEngine;
+  }
+
+  void Evaluate(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    while (state.KeepRunning())
+      jsEngine->Evaluate("1 + 1");
+  }
+
+  // The argument is the length of the string.
+  void NewStringValue(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    const std::string value(static_cast<size_t>(state.Arg()), 'x');
+    while (state.KeepRunning())
+      jsEngine->NewValue(value);
+    state.SetItemsProcessed(state.Iterations() * state.Arg());
+  }
+
+  void AsString(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value =
+      jsEngine->NewValue(std::string(static_cast<size_t>(state.Arg()), 'x'));
+    while (state.KeepRunning())
+      value->AsString();
+    state.SetItemsProcessed(state.Iterations() * state.Arg());
+  }
+
+  void NewObject(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    while (state.KeepRunning())
+      jsEngine->NewObject();
+  }
+
+  void Call(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr function =
+      jsEngine->Evaluate("(function(a, b) {return a + b;})");
+    AdblockPlus::JsValueList params;
+    params.push_back(jsEngine->NewValue(1));
+    params.push_back(jsEngine->NewValue(2));
+    while (state.KeepRunning())
+      function->Call(params);
+  }
+
+  void GetProperty(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr object =
+      jsEngine->Evaluate("({text: '||example.com^'})");
+    while (state.KeepRunning())
+      object->GetProperty("text");
+  }
+
+  void SetProperty(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr object = jsEngine->NewObject();
+    const std::string value("||example.com^");
+    while (state.KeepRunning())
+      object->SetProperty("text", value);
+  }
+
+  // The argument is the length of the array.
+  void AsList(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValueList params;
+    params.push_back(jsEngine->NewValue(state.Arg()));
+    AdblockPlus::JsValuePtr array = jsEngine->Evaluate(
+        "(function(n) {var a = []; for (var i = 0; i < n; i++) a.push(i); return a;})")
+      ->Call(params);
+    while (state.KeepRunning())
+      array->AsList();
+    state.SetItemsProcessed(state.Iterations() * state.Arg());
+  }
+
+  void JsContextConstruction(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    while (state.KeepRunning())
+      const AdblockPlus::JsContext context(jsEngine);
+  }
+
+  // Within a JsEngine::Scope the lock is already held.
+  void JsContextConstructionNested(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    while (state.KeepRunning())
+      const AdblockPlus::JsContext context(jsEngine);
+  }
+
+  // All threads take turns locking the same engine.
+  void JsContextContended(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = GetSharedJsEngine();
+    while (state.KeepRunning())
+      const AdblockPlus::JsContext context(jsEngine);
+  }
+
+  void GetPropertyContended(Benchmark::State& state)
+  {
+    GetSharedJsEngine();
+    while (state.KeepRunning())
+      (*sharedObject)->GetProperty("text")->AsString();
+  }
+}
+
+BENCHMARK(Evaluate);
+BENCHMARK(NewStringValue)->Range(8, 1 << 20);
+BENCHMARK(AsString)->Range(8, 1 << 20);
+BENCHMARK(NewObject);
+BENCHMARK(Call);
+BENCHMARK(GetProperty);
+BENCHMARK(SetProperty);
+BENCHMARK(AsList)->Range(8, 4096);
+BENCHMARK(JsContextConstruction);
+BENCHMARK(JsContextConstructionNested);
+BENCHMARK(JsContextContended)->ThreadRange(1, 32);
+BENCHMARK(GetPropertyContended)->ThreadRange(1, 32);
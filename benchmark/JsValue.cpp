@@ -0,0 +1,226 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+
+#include "BaseBenchmark.h"
+#include "../src/JsContext.h"
+#include "../src/Utils.h"
+
+namespace
+{
+  // Creates a string of the requested length, either ASCII only or with a
+  // non-Latin-1 character forcing a two-byte representation.
+  AdblockPlus::JsValuePtr CreateString(AdblockPlus::JsEnginePtr jsEngine,
+                                       int64_t length, bool twoByte)
+  {
+    std::string source("(function(n, c) {var s = ''; while (s.length < n) s += c; return s;})");
+    AdblockPlus::JsValueList params;
+    params.push_back(jsEngine->NewValue(length));
+    params.push_back(jsEngine->NewValue(twoByte ? "\xE2\x82\xAC" : "x"));
+    return jsEngine->Evaluate(source)->Call(params);
+  }
+
+  void Utf8ValueConversion(Benchmark::State& state, bool twoByte)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value = CreateString(jsEngine, state.Arg(), twoByte);
+    const AdblockPlus::JsContext context(jsEngine);
+    v8::Local<v8::Value> v8Value = value->UnwrapValue();
+    while (state.KeepRunning())
+    {
+      // The conversion FromV8String used to do
+      v8::String::Utf8Value stringValue(v8Value);
+      std::string result(*stringValue, stringValue.length());
+    }
+  }
+
+  void FromV8StringConversion(Benchmark::State& state, bool twoByte)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value = CreateString(jsEngine, state.Arg(), twoByte);
+    const AdblockPlus::JsContext context(jsEngine);
+    v8::Local<v8::Value> v8Value = value->UnwrapValue();
+    while (state.KeepRunning())
+      std::string result = AdblockPlus::Utils::FromV8String(v8Value);
+  }
+
+  void Utf8ValueOneByte(Benchmark::State& state)
+  {
+    Utf8ValueConversion(state, false);
+  }
+
+  void Utf8ValueTwoByte(Benchmark::State& state)
+  {
+    Utf8ValueConversion(state, true);
+  }
+
+  void FromV8StringOneByte(Benchmark::State& state)
+  {
+    FromV8StringConversion(state, false);
+  }
+
+  void FromV8StringTwoByte(Benchmark::State& state)
+  {
+    FromV8StringConversion(state, true);
+  }
+
+  void AppendV8String(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value = CreateString(jsEngine, state.Arg(), false);
+    const AdblockPlus::JsContext context(jsEngine);
+    v8::Local<v8::Value> v8Value = value->UnwrapValue();
+    std::string buffer;
+    while (state.KeepRunning())
+    {
+      buffer.clear();
+      AdblockPlus::Utils::AppendV8String(buffer, v8Value);
+    }
+  }
+
+  // Reads a few properties of an object, the way a Filter is inspected.
+  void ReadProperties(Benchmark::State& state, bool scoped)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value =
+      jsEngine->Evaluate("({text: '||example.com^', type: 'blocking', disabled: false})");
+    while (state.KeepRunning())
+    {
+      std::unique_ptr<AdblockPlus::JsEngine::Scope> scope;
+      if (scoped)
+        scope.reset(new AdblockPlus::JsEngine::Scope(jsEngine));
+      value->IsObject();
+      value->GetProperty("text")->AsString();
+      value->GetProperty("type")->AsString();
+      value->GetProperty("disabled")->AsBool();
+    }
+  }
+
+  void NewValue(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    while (state.KeepRunning())
+      jsEngine->NewValue(42);
+  }
+
+  // Keeps a number of values alive, as a caller holding on to results would.
+  void NewValueRetained(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    AdblockPlus::JsValueList values(static_cast<size_t>(state.Arg()));
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      values[index] = jsEngine->NewValue(42);
+      index = (index + 1) % values.size();
+    }
+  }
+
+  AdblockPlus::JsValuePtr CreateStringArray(AdblockPlus::JsEnginePtr jsEngine,
+                                            int64_t length)
+  {
+    std::string source("(function(n) {var a = []; for (var i = 0; i < n; i++) a.push('##.ad-' + i); return a;})");
+    AdblockPlus::JsValueList params;
+    params.push_back(jsEngine->NewValue(length));
+    return jsEngine->Evaluate(source)->Call(params);
+  }
+
+  void AsListAsString(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value = CreateStringArray(jsEngine, state.Arg());
+    while (state.KeepRunning())
+    {
+      // What callers had to do before AsStringVector() existed
+      AdblockPlus::JsValueList list = value->AsList();
+      std::vector<std::string> result;
+      for (AdblockPlus::JsValueList::iterator it = list.begin();
+           it != list.end(); ++it)
+      {
+        result.push_back((*it)->AsString());
+      }
+    }
+    state.SetItemsProcessed(state.Iterations() * state.Arg());
+  }
+
+  void AsStringVector(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    AdblockPlus::JsValuePtr value = CreateStringArray(jsEngine, state.Arg());
+    while (state.KeepRunning())
+      value->AsStringVector();
+    state.SetItemsProcessed(state.Iterations() * state.Arg());
+  }
+
+  // Builds a result object the way WebRequestThread::Run() does.
+  void SetPropertiesByString(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    while (state.KeepRunning())
+    {
+      AdblockPlus::JsValuePtr result = jsEngine->NewObject();
+      result->SetProperty("status", 0);
+      result->SetProperty("responseStatus", 200);
+      result->SetProperty("responseText", "");
+    }
+  }
+
+  void SetPropertiesByName(Benchmark::State& state)
+  {
+    static const AdblockPlus::PropertyName statusName("status");
+    static const AdblockPlus::PropertyName responseStatusName("responseStatus");
+    static const AdblockPlus::PropertyName responseTextName("responseText");
+
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    while (state.KeepRunning())
+    {
+      AdblockPlus::JsValuePtr result = jsEngine->NewObject();
+      result->SetProperty(statusName, 0);
+      result->SetProperty(responseStatusName, 200);
+      result->SetProperty(responseTextName, "");
+    }
+  }
+
+  void ReadPropertiesUnscoped(Benchmark::State& state)
+  {
+    ReadProperties(state, false);
+  }
+
+  void ReadPropertiesScoped(Benchmark::State& state)
+  {
+    ReadProperties(state, true);
+  }
+}
+
+BENCHMARK(Utf8ValueOneByte)->Range(8, 1 << 20);
+BENCHMARK(Utf8ValueTwoByte)->Range(8, 1 << 20);
+BENCHMARK(FromV8StringOneByte)->Range(8, 1 << 20);
+BENCHMARK(FromV8StringTwoByte)->Range(8, 1 << 20);
+BENCHMARK(AppendV8String)->Range(8, 1 << 20);
+BENCHMARK(ReadPropertiesUnscoped);
+BENCHMARK(ReadPropertiesScoped);
+BENCHMARK(NewValue);
+BENCHMARK(NewValueRetained)->Range(8, 4096);
+BENCHMARK(AsListAsString)->Range(8, 4096);
+BENCHMARK(AsStringVector)->Range(8, 4096);
+BENCHMARK(SetPropertiesByString);
+BENCHMARK(SetPropertiesByName);
@@ -0,0 +1,140 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+
+#include "BaseBenchmark.h"
+#include "FilterData.h"
+
+namespace
+{
+  // Number of generated requests, each iteration matches one of them.
+  const int requestCount = 10000;
+
+  // Shared by all threads of MatchRequestsSharedEngine. Never destroyed:
+  // V8 is shut down by a static destructor that could run first.
+  std::mutex sharedFilterEngineMutex;
+  AdblockPlus::FilterEngine* sharedFilterEngine = nullptr;
+
+  AdblockPlus::FilterEngine& GetSharedFilterEngine()
+  {
+    std::lock_guard<std::mutex> lock(sharedFilterEngineMutex);
+    if (!sharedFilterEngine)
+    {
+      sharedFilterEngine =
+        FilterData::CreateFilterEngine(CreateBenchmarkJsEngine()).release();
+    }
+    return *sharedFilterEngine;
+  }
+
+  // Replays the corpus against EasyList and EasyPrivacy, reporting the
+  // latency of every single request.
+  void MatchRequests(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    std::unique_ptr<AdblockPlus::FilterEngine> filterEngine =
+      FilterData::CreateFilterEngine(jsEngine);
+    const FilterData::Corpus corpus(FilterData::LoadRequests(requestCount));
+    AdblockPlus::MatchResult result;
+    int64_t blocked = 0;
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      const FilterData::Request& request = corpus.requests[index];
+      const Benchmark::Clock::time_point start = Benchmark::Clock::now();
+      filterEngine->Matches(request.url, request.contentType,
+          corpus.documentUrls[index], result);
+      state.RecordLatency(Benchmark::Clock::now() - start);
+      if (result.decision == AdblockPlus::MatchResult::DECISION_BLOCK)
+        blocked++;
+      index = (index + 1) % corpus.requests.size();
+    }
+    state.SetCounter("blocked", static_cast<double>(blocked) / state.Iterations());
+  }
+
+  // Same as above with the overload creating a Filter wrapper per match.
+  void MatchRequestsWithFilter(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    std::unique_ptr<AdblockPlus::FilterEngine> filterEngine =
+      FilterData::CreateFilterEngine(jsEngine);
+    const FilterData::Corpus corpus(FilterData::LoadRequests(requestCount));
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      const FilterData::Request& request = corpus.requests[index];
+      const Benchmark::Clock::time_point start = Benchmark::Clock::now();
+      filterEngine->Matches(request.url, request.contentType,
+          corpus.documentUrls[index]);
+      state.RecordLatency(Benchmark::Clock::now() - start);
+      index = (index + 1) % corpus.requests.size();
+    }
+  }
+
+  // Every thread replays the corpus, starting at a different request. Lock
+  // wait time is reported per match. Engine-wide statistics are only
+  // reported by the first thread if the engine is shared, the other threads
+  // run at the same time and would count the same waits again.
+  void MatchConcurrently(Benchmark::State& state,
+                         AdblockPlus::FilterEngine& filterEngine, bool shared)
+  {
+    const FilterData::Corpus corpus(FilterData::LoadRequests(requestCount));
+    AdblockPlus::JsEnginePtr jsEngine = filterEngine.GetJsEngine();
+    const int64_t lockWaitTime = jsEngine->GetStatistics().lockWaitTime;
+    AdblockPlus::MatchResult result;
+    size_t index = state.ThreadIndex() * corpus.requests.size() / state.Threads();
+    while (state.KeepRunning())
+    {
+      const FilterData::Request& request = corpus.requests[index];
+      const Benchmark::Clock::time_point start = Benchmark::Clock::now();
+      filterEngine.Matches(request.url, request.contentType,
+          corpus.documentUrls[index], result);
+      state.RecordLatency(Benchmark::Clock::now() - start);
+      index = (index + 1) % corpus.requests.size();
+    }
+
+    if (!shared || state.ThreadIndex() == 0)
+    {
+      const double matches =
+        static_cast<double>(state.Iterations()) * state.Threads();
+      state.SetCounter("lockWaitUs",
+          (jsEngine->GetStatistics().lockWaitTime - lockWaitTime) / matches);
+    }
+  }
+
+  void MatchRequestsSharedEngine(Benchmark::State& state)
+  {
+    MatchConcurrently(state, GetSharedFilterEngine(), true);
+  }
+
+  // Each thread has an engine with its own isolate, as a baseline for a
+  // concurrent read path.
+  void MatchRequestsPerThreadEngine(Benchmark::State& state)
+  {
+    std::unique_ptr<AdblockPlus::FilterEngine> filterEngine =
+      FilterData::CreateFilterEngine(CreateBenchmarkJsEngine());
+    MatchConcurrently(state, *filterEngine, false);
+  }
+}
+
+// Fixed iterations so that every run goes over the corpus the same way,
+// ten times.
+BENCHMARK(MatchRequests)->Iterations(requestCount * 10);
+BENCHMARK(MatchRequestsWithFilter)->Iterations(requestCount * 10);
+BENCHMARK(MatchRequestsSharedEngine)->ThreadRange(1, 16)->Iterations(requestCount * 2);
+// Fewer threads here, every engine loads all filters.
+BENCHMARK(MatchRequestsPerThreadEngine)->ThreadRange(1, 8)->Iterations(requestCount * 2);
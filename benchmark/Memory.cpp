@@ -0,0 +1,156 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <fstream>
+#include <unistd.h>
+#endif
+
+#include "BaseBenchmark.h"
+#include "FilterData.h"
+
+namespace
+{
+  struct MemoryUsage
+  {
+    int64_t heapUsed;
+    int64_t residentSetSize;
+    int64_t nativeAllocations;
+    int64_t nativeBytes;
+  };
+
+  // Resident set size of the process, 0 where this isn't supported.
+  int64_t GetResidentSetSize()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+      return 0;
+    return counters.WorkingSetSize;
+#else
+    std::ifstream statm("/proc/self/statm");
+    int64_t size = 0;
+    int64_t resident = 0;
+    if (!(statm >> size >> resident))
+      return 0;
+    return resident * sysconf(_SC_PAGESIZE);
+#endif
+  }
+
+  // Loads the filters into a filter engine with its own isolate and returns
+  // how much memory that took once the engine is idle.
+  MemoryUsage MeasureFilterEngine(const FilterData::FilterList& filters)
+  {
+    const AdblockPlus::FileSystemPtr fileSystem =
+      FilterData::CreateFileSystem(filters);
+    const int64_t residentSetSizeBefore = GetResidentSetSize();
+    Benchmark::EnableProcessAllocationCounting(true);
+    const Benchmark::ProcessAllocationCount allocationsBefore =
+      Benchmark::GetProcessAllocationCount();
+
+    MemoryUsage result;
+    {
+      AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+      std::unique_ptr<AdblockPlus::FilterEngine> filterEngine =
+        FilterData::CreateFilterEngine(jsEngine, fileSystem);
+      jsEngine->Gc();
+
+      const Benchmark::ProcessAllocationCount allocationsAfter =
+        Benchmark::GetProcessAllocationCount();
+      result.heapUsed = jsEngine->GetStatistics().usedHeapSize;
+      result.residentSetSize = GetResidentSetSize() - residentSetSizeBefore;
+      result.nativeAllocations =
+        allocationsAfter.allocations - allocationsBefore.allocations;
+      result.nativeBytes =
+        allocationsAfter.liveBytes - allocationsBefore.liveBytes;
+    }
+    Benchmark::EnableProcessAllocationCounting(false);
+    return result;
+  }
+
+  // Reports the memory used per filter, compared to a filter engine without
+  // any filters. RSS is only a rough indication, the allocator doesn't
+  // necessarily return memory freed by previous runs to the system.
+  void MeasureFilters(Benchmark::State& state,
+                      const FilterData::FilterList& filters)
+  {
+    while (state.KeepRunning())
+    {
+      const MemoryUsage empty = MeasureFilterEngine(FilterData::FilterList());
+      const MemoryUsage loaded = MeasureFilterEngine(filters);
+      const double count = static_cast<double>(filters.size());
+      state.SetCounter("heapBytesPerFilter",
+          (loaded.heapUsed - empty.heapUsed) / count);
+      state.SetCounter("rssBytesPerFilter",
+          (loaded.residentSetSize - empty.residentSetSize) / count);
+      state.SetCounter("nativeAllocsPerFilter",
+          (loaded.nativeAllocations - empty.nativeAllocations) / count);
+      state.SetCounter("nativeBytesPerFilter",
+          (loaded.nativeBytes - empty.nativeBytes) / count);
+    }
+  }
+
+  void MeasureFilterType(Benchmark::State& state,
+                         AdblockPlus::Filter::Type type)
+  {
+    FilterData::FilterList filters;
+    for (int64_t i = 0; i < state.Arg(); i++)
+      filters.push_back(FilterData::GenerateFilter(type, static_cast<int>(i)));
+    MeasureFilters(state, filters);
+  }
+
+  void MemoryBlockingFilters(Benchmark::State& state)
+  {
+    MeasureFilterType(state, AdblockPlus::Filter::TYPE_BLOCKING);
+  }
+
+  void MemoryExceptionFilters(Benchmark::State& state)
+  {
+    MeasureFilterType(state, AdblockPlus::Filter::TYPE_EXCEPTION);
+  }
+
+  void MemoryElemHideFilters(Benchmark::State& state)
+  {
+    MeasureFilterType(state, AdblockPlus::Filter::TYPE_ELEMHIDE);
+  }
+
+  void MemoryCommentFilters(Benchmark::State& state)
+  {
+    MeasureFilterType(state, AdblockPlus::Filter::TYPE_COMMENT);
+  }
+
+  // EasyList's mix of filter types, or the real list if BENCHMARK_DATA_DIR
+  // is set, cut to the requested size.
+  void MemoryEasyList(Benchmark::State& state)
+  {
+    FilterData::FilterList filters = FilterData::LoadFilterList(
+        "easylist.txt", static_cast<int>(state.Arg()), 0);
+    if (filters.size() > static_cast<size_t>(state.Arg()))
+      filters.resize(static_cast<size_t>(state.Arg()));
+    MeasureFilters(state, filters);
+  }
+}
+
+// Every iteration loads the filters twice, once is enough.
+BENCHMARK(MemoryBlockingFilters)->Arg(1000)->Arg(10000)->Arg(100000)->Iterations(1);
+BENCHMARK(MemoryExceptionFilters)->Arg(1000)->Arg(10000)->Arg(100000)->Iterations(1);
+BENCHMARK(MemoryElemHideFilters)->Arg(1000)->Arg(10000)->Arg(100000)->Iterations(1);
+BENCHMARK(MemoryCommentFilters)->Arg(1000)->Arg(10000)->Arg(100000)->Iterations(1);
+BENCHMARK(MemoryEasyList)->Arg(1000)->Arg(10000)->Arg(50000)->Iterations(1);
@@ -0,0 +1,59 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Benchmark.h"
+#include "../src/MemoryPool.h"
+
+namespace
+{
+  // Roughly the size of a JsValue
+  struct Value
+  {
+    virtual ~Value()
+    {
+    }
+
+    std::shared_ptr<int> owner;
+    void* handle;
+  };
+
+  void SharedPtrNew(Benchmark::State& state)
+  {
+    while (state.KeepRunning())
+      std::shared_ptr<Value> value(new Value);
+  }
+
+  void MakeShared(Benchmark::State& state)
+  {
+    while (state.KeepRunning())
+      std::shared_ptr<Value> value = std::make_shared<Value>();
+  }
+
+  void PoolAllocateShared(Benchmark::State& state)
+  {
+    AdblockPlus::MemoryPool pool(128);
+    while (state.KeepRunning())
+    {
+      std::shared_ptr<Value> value = std::allocate_shared<Value>(
+          AdblockPlus::PoolAllocator<Value>(pool));
+    }
+  }
+}
+
+BENCHMARK(SharedPtrNew)->ThreadRange(1, 4);
+BENCHMARK(MakeShared)->ThreadRange(1, 4);
+BENCHMARK(PoolAllocateShared)->ThreadRange(1, 4);
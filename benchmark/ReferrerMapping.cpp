@@ -0,0 +1,131 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <AdblockPlus/ConcurrentReferrerMapping.h>
+#include <AdblockPlus/ReferrerMapping.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+  typedef std::vector<std::pair<std::string, std::string> > RequestList;
+
+  const int resourcesPerPage = 20;
+
+  // Shared by all benchmark threads, the way a browser or proxy would share
+  // a single mapping.
+  AdblockPlus::ReferrerMapping lockedReferrerMapping;
+  std::mutex referrerMappingMutex;
+  AdblockPlus::ConcurrentReferrerMapping concurrentReferrerMapping;
+
+  std::string PageUrl(int64_t page)
+  {
+    std::stringstream url;
+    url << "https://www.example" << page % 100 << ".com/articles/"
+        << page << "/some-article-title.html";
+    return url.str();
+  }
+
+  // Simulates browsing: every page is navigated to from the previous one and
+  // loads a number of resources.
+  RequestList CreateRequests(int64_t count, int64_t offset = 0)
+  {
+    RequestList requests;
+    for (int64_t i = offset; i < offset + count; i++)
+    {
+      const int64_t page = i / resourcesPerPage;
+      if (i % resourcesPerPage == 0)
+        requests.push_back(std::make_pair(PageUrl(page), PageUrl(page - 1)));
+      else
+      {
+        std::stringstream url;
+        url << "https://cdn.example" << page % 100
+            << ".com/static/images/" << i << ".png?size=large";
+        requests.push_back(std::make_pair(url.str(), PageUrl(page)));
+      }
+    }
+    return requests;
+  }
+
+  // The argument is the number of distinct URLs, more than the default
+  // capacity of 5000 means that old mappings are dropped.
+  void ReferrerMappingAdd(Benchmark::State& state)
+  {
+    const RequestList requests = CreateRequests(state.Arg());
+    AdblockPlus::ReferrerMapping referrerMapping;
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      referrerMapping.Add(requests[index].first, requests[index].second);
+      index = (index + 1) % requests.size();
+    }
+  }
+
+  void ReferrerMappingBuildChain(Benchmark::State& state)
+  {
+    const RequestList requests = CreateRequests(5000);
+    AdblockPlus::ReferrerMapping referrerMapping;
+    for (size_t i = 0; i < requests.size(); i++)
+      referrerMapping.Add(requests[i].first, requests[i].second);
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      referrerMapping.BuildReferrerChain(requests[index].first);
+      index = (index + 1) % requests.size();
+    }
+  }
+
+  // Every thread browses different pages, half of the calls build a chain.
+  void LockedReferrerMapping(Benchmark::State& state)
+  {
+    const RequestList requests = CreateRequests(10000,
+        state.ThreadIndex() * 10000);
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      std::lock_guard<std::mutex> lock(referrerMappingMutex);
+      if (index % 2)
+        lockedReferrerMapping.BuildReferrerChain(requests[index].first);
+      else
+        lockedReferrerMapping.Add(requests[index].first, requests[index].second);
+      index = (index + 1) % requests.size();
+    }
+  }
+
+  void ConcurrentReferrerMapping(Benchmark::State& state)
+  {
+    const RequestList requests = CreateRequests(10000,
+        state.ThreadIndex() * 10000);
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+      if (index % 2)
+        concurrentReferrerMapping.BuildReferrerChain(requests[index].first);
+      else
+        concurrentReferrerMapping.Add(requests[index].first, requests[index].second);
+      index = (index + 1) % requests.size();
+    }
+  }
+}
+
+BENCHMARK(ReferrerMappingAdd)->Arg(1000)->Arg(100000)->Iterations(1000000);
+BENCHMARK(ReferrerMappingBuildChain)->Iterations(1000000);
+BENCHMARK(LockedReferrerMapping)->ThreadRange(1, 8);
+BENCHMARK(ConcurrentReferrerMapping)->ThreadRange(1, 8);
@@ -0,0 +1,93 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BaseBenchmark.h"
+#include "FilterData.h"
+
+namespace
+{
+  double Milliseconds(int64_t microseconds)
+  {
+    return microseconds / 1000.0;
+  }
+
+  // Creates a complete filter engine per iteration, with as many filters as
+  // the argument says. A cold start creates a new isolate, a warm start
+  // reuses an isolate that already ran a filter engine before.
+  void Startup(Benchmark::State& state, bool warm)
+  {
+    const AdblockPlus::FileSystemPtr fileSystem = FilterData::CreateFileSystem(
+        FilterData::GenerateFilterList(static_cast<int>(state.Arg()), 0));
+    AdblockPlus::ScopedV8IsolatePtr isolate;
+    if (warm)
+    {
+      isolate = std::make_shared<AdblockPlus::ScopedV8Isolate>();
+      FilterData::CreateFilterEngine(CreateBenchmarkJsEngine(isolate),
+          fileSystem);
+    }
+
+    AdblockPlus::FilterEngineStartupReport sum = AdblockPlus::FilterEngineStartupReport();
+    int64_t scriptEvaluation = 0;
+    int64_t jsEngineSetup = 0;
+    while (state.KeepRunning())
+    {
+      AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine(isolate);
+      std::unique_ptr<AdblockPlus::FilterEngine> filterEngine =
+        FilterData::CreateFilterEngine(jsEngine, fileSystem);
+
+      state.PauseTiming();
+      const AdblockPlus::FilterEngineStartupReport& report =
+        filterEngine->GetStartupReport();
+      jsEngineSetup += report.jsEngine.isolateCreation +
+        report.jsEngine.contextCreation + report.jsEngine.globalSetup;
+      for (size_t i = 0; i < report.scriptEvaluation.size(); i++)
+        scriptEvaluation += report.scriptEvaluation[i].second;
+      sum.prefsLoaded += report.prefsLoaded;
+      sum.filtersLoaded += report.filtersLoaded;
+      sum.matchersPopulated += report.matchersPopulated;
+      sum.initialized += report.initialized;
+      // Tearing down is not part of the startup
+      filterEngine.reset();
+      jsEngine.reset();
+      state.ResumeTiming();
+    }
+
+    // Averages in milliseconds, the last four are measured from the start of
+    // the FilterEngine constructor.
+    const int64_t iterations = state.Iterations();
+    state.SetCounter("jsEngineMs", Milliseconds(jsEngineSetup / iterations));
+    state.SetCounter("scriptsMs", Milliseconds(scriptEvaluation / iterations));
+    state.SetCounter("prefsMs", Milliseconds(sum.prefsLoaded / iterations));
+    state.SetCounter("filtersMs", Milliseconds(sum.filtersLoaded / iterations));
+    state.SetCounter("matchersMs",
+        Milliseconds(sum.matchersPopulated / iterations));
+    state.SetCounter("initMs", Milliseconds(sum.initialized / iterations));
+  }
+
+  void ColdStartup(Benchmark::State& state)
+  {
+    Startup(state, false);
+  }
+
+  void WarmStartup(Benchmark::State& state)
+  {
+    Startup(state, true);
+  }
+}
+
+BENCHMARK(ColdStartup)->Arg(0)->Arg(10000)->Arg(100000)->Iterations(5);
+BENCHMARK(WarmStartup)->Arg(0)->Arg(10000)->Arg(100000)->Iterations(5);
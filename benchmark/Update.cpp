@@ -0,0 +1,141 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include "BaseBenchmark.h"
+#include "FilterData.h"
+
+namespace
+{
+  // Size of the new EasyList version, none of its filters are in the old one.
+  const int newListSize = 50000;
+  const int requestCount = 10000;
+
+  // Serves a new version of EasyList without any network delay, so that
+  // only the work done by the filter engine is measured.
+  class FilterListWebRequest : public AdblockPlus::WebRequest
+  {
+  public:
+    explicit FilterListWebRequest(const std::string& filterList)
+      : filterList(filterList)
+    {
+    }
+
+    AdblockPlus::ServerResponse GET(const std::string& url,
+        const AdblockPlus::HeaderList& requestHeaders) const
+    {
+      AdblockPlus::ServerResponse result;
+      if (url.find(FilterData::easyListUrl) == 0)
+      {
+        result.status = NS_OK;
+        result.responseStatus = 200;
+        result.responseText = filterList;
+      }
+      else
+      {
+        result.status = NS_ERROR_FAILURE;
+        result.responseStatus = 0;
+      }
+      return result;
+    }
+
+  private:
+    const std::string filterList;
+  };
+
+  void SetPercentileCounters(Benchmark::State& state, const std::string& prefix,
+                             std::vector<int64_t>& latencies)
+  {
+    if (latencies.empty())
+      return;
+    std::sort(latencies.begin(), latencies.end());
+    state.SetCounter(prefix + "P50Us", Benchmark::Percentile(latencies, 50));
+    state.SetCounter(prefix + "P99Us", Benchmark::Percentile(latencies, 99));
+    state.SetCounter(prefix + "P999Us", Benchmark::Percentile(latencies, 99.9));
+    state.SetCounter(prefix + "MaxUs", Benchmark::Percentile(latencies, 100));
+  }
+
+  // Keeps matching while EasyList is updated to a new version, and for as
+  // many requests again once the update is done. One iteration is the whole
+  // scenario, the interesting numbers are the counters.
+  void UpdateUnderLoad(Benchmark::State& state)
+  {
+    AdblockPlus::JsEnginePtr jsEngine = CreateBenchmarkJsEngine();
+    std::unique_ptr<AdblockPlus::FilterEngine> filterEngine =
+      FilterData::CreateFilterEngine(jsEngine);
+    jsEngine->SetWebRequest(AdblockPlus::WebRequestPtr(new FilterListWebRequest(
+        FilterData::FormatFilterList(
+            FilterData::GenerateFilterList(newListSize, 2), 2))));
+    const FilterData::Corpus corpus(FilterData::LoadRequests(requestCount));
+    AdblockPlus::SubscriptionPtr subscription =
+      filterEngine->GetSubscription(FilterData::easyListUrl);
+
+    std::atomic<bool> updated(false);
+    filterEngine->SetFilterChangeCallback(
+        [&updated](const std::string& action, const AdblockPlus::JsValuePtr)
+        {
+          if (action == "subscription.updated")
+            updated = true;
+        });
+
+    std::vector<int64_t> duringUpdate;
+    std::vector<int64_t> afterUpdate;
+    int64_t updateTime = 0;
+    AdblockPlus::MatchResult result;
+    while (state.KeepRunning())
+    {
+      const Benchmark::Clock::time_point updateStart = Benchmark::Clock::now();
+      subscription->UpdateFilters();
+      for (size_t i = 0; !updateTime || afterUpdate.size() < duringUpdate.size(); i++)
+      {
+        const size_t index = i % corpus.requests.size();
+        const FilterData::Request& request = corpus.requests[index];
+        const Benchmark::Clock::time_point start = Benchmark::Clock::now();
+        filterEngine->Matches(request.url, request.contentType,
+            corpus.documentUrls[index], result);
+        const Benchmark::Clock::time_point end = Benchmark::Clock::now();
+        const int64_t latency =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+        if (updateTime)
+          afterUpdate.push_back(latency);
+        else
+        {
+          duringUpdate.push_back(latency);
+          if (updated)
+          {
+            updateTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                end - updateStart).count();
+          }
+          else if (end - updateStart > std::chrono::minutes(1))
+            throw std::runtime_error("Subscription wasn't updated");
+        }
+      }
+    }
+    filterEngine->RemoveFilterChangeCallback();
+
+    state.SetCounter("updateMs", updateTime / 1000.0);
+    state.SetCounter("matchesDuring", static_cast<double>(duringUpdate.size()));
+    SetPercentileCounters(state, "during", duringUpdate);
+    SetPercentileCounters(state, "after", afterUpdate);
+  }
+}
+
+BENCHMARK(UpdateUnderLoad)->Iterations(1);
@@ -31,6 +31,8 @@
 #define ADBLOCK_PLUS_ADBLOCK_PLUS_H
 
 #include <AdblockPlus/AppInfo.h>
+#include <AdblockPlus/AsyncLogSystem.h>
+#include <AdblockPlus/ConcurrentReferrerMapping.h>
 #include <AdblockPlus/FileSystem.h>
 #include <AdblockPlus/DefaultLogSystem.h>
 #include <AdblockPlus/DefaultFileSystem.h>
@@ -39,6 +41,7 @@
 #include <AdblockPlus/LogSystem.h>
 #include <AdblockPlus/JsEngine.h>
 #include <AdblockPlus/JsValue.h>
+#include <AdblockPlus/LatencyHistogram.h>
 #include <AdblockPlus/ReferrerMapping.h>
 #include <AdblockPlus/WebRequest.h>
 #include "AdblockPlus/Notification.h"
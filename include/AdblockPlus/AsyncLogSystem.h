@@ -0,0 +1,108 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_ASYNC_LOG_SYSTEM_H
+#define ADBLOCK_PLUS_ASYNC_LOG_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+#include "LogSystem.h"
+
+namespace AdblockPlus
+{
+  /**
+   * `LogSystem` implementation passing messages on to another `LogSystem` on
+   * a background thread. Logging only copies the message into a fixed-size
+   * ring buffer without blocking on the consumer, so it doesn't slow down
+   * the JavaScript thread. Messages are dropped while the buffer is full.
+   */
+  class AsyncLogSystem : public LogSystem
+  {
+  public:
+    /**
+     * Starts the background thread.
+     * @param target Log system to write the messages to. Its `IsEnabled()`
+     *        and `NeedsSource()` are used as they are.
+     * @param capacity Number of messages the buffer can hold, rounded up to
+     *        a power of two.
+     */
+    explicit AsyncLogSystem(const LogSystemPtr& target, size_t capacity = 1024);
+
+    /**
+     * Writes all pending messages and stops the background thread.
+     */
+    ~AsyncLogSystem();
+
+    void operator()(LogLevel logLevel, const std::string& message,
+          const std::string& source);
+    bool IsEnabled(LogLevel logLevel) const;
+    bool NeedsSource() const;
+
+    /**
+     * Waits until all messages logged so far have been written.
+     */
+    void Flush();
+
+    /**
+     * Returns the number of messages dropped because the buffer was full.
+     * @return Number of dropped messages.
+     */
+    int64_t GetDroppedMessageCount() const;
+
+  private:
+    struct Message
+    {
+      /// Position in the log this slot can be used for next, written after
+      /// the slot's contents.
+      std::atomic<size_t> sequence;
+      LogLevel logLevel;
+      std::string message;
+      std::string source;
+    };
+
+    class FlushThread;
+
+    AsyncLogSystem(const AsyncLogSystem&);
+    AsyncLogSystem& operator=(const AsyncLogSystem&);
+
+    bool WritePending();
+    bool HasPending() const;
+
+    const LogSystemPtr target;
+    const size_t capacity;
+    std::unique_ptr<Message[]> buffer;
+    std::atomic<size_t> enqueuePosition;
+    std::atomic<size_t> dequeuePosition;
+    std::atomic<int64_t> droppedMessages;
+    std::atomic<bool> stopped;
+    /// Set while the background thread is about to wait for messages, only
+    /// then loggers need to wake it up.
+    std::atomic<bool> waiting;
+    std::mutex mutex;
+    std::condition_variable messagesAvailable;
+    std::condition_variable messagesWritten;
+    std::unique_ptr<FlushThread> flushThread;
+  };
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_CONCURRENT_REFERRER_MAPPING_H
+#define ADBLOCK_PLUS_CONCURRENT_REFERRER_MAPPING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <AdblockPlus/ReferrerMapping.h>
+
+namespace AdblockPlus
+{
+  /**
+   * Thread-safe variant of `ReferrerMapping`.
+   * URLs are distributed over a number of shards, each with its own lock, so
+   * that threads recording or looking up different URLs rarely wait for each
+   * other. The limits apply to all shards together: nothing is dropped
+   * before they are reached. Once they are, the least recently added URL of
+   * all shards is dropped, just like with `ReferrerMapping`. Only URLs added
+   * concurrently can be dropped in a slightly different order.
+   */
+  class ConcurrentReferrerMapping
+  {
+  public:
+    /**
+     * Constructor.
+     * @param maxCachedUrls Number of URL mappings to store, see
+     *        `ReferrerMapping`.
+     * @param maxCachedBytes Maximum total length of the stored URLs and
+     *        referrers, 0 for no limit.
+     * @param shardCount Number of shards, more shards reduce contention.
+     */
+    ConcurrentReferrerMapping(const int maxCachedUrls = 5000,
+                              const size_t maxCachedBytes = 0,
+                              const int shardCount = 16);
+
+    /**
+     * Records the refferer for a URL.
+     * @param url Request URL.
+     * @param referrer Request referrer.
+     */
+    void Add(const std::string& url, const std::string& referrer);
+
+    /**
+     * Builds a chain of referrers for the supplied URL, see
+     * `ReferrerMapping::BuildReferrerChain()`.
+     * @param url URL to build the chain for.
+     * @return List of URLs, ending with `url`.
+     */
+    std::vector<std::string> BuildReferrerChain(const std::string& url) const;
+
+  private:
+    struct Shard
+    {
+      Shard();
+
+      void UpdateOldestSequence();
+
+      mutable std::mutex mutex;
+      ReferrerMapping mapping;
+      /// Sequence number of the shard's least recently added URL, so that
+      /// eviction can find the oldest URL without locking every shard.
+      std::atomic<uint64_t> oldestSequence;
+    };
+
+    ConcurrentReferrerMapping(const ConcurrentReferrerMapping&);
+    ConcurrentReferrerMapping& operator=(const ConcurrentReferrerMapping&);
+
+    Shard& GetShard(const std::string& url) const;
+    bool IsFull() const;
+
+    const int maxCachedUrls;
+    const size_t maxCachedBytes;
+    std::vector<std::unique_ptr<Shard> > shards;
+    std::atomic<int> cachedUrls;
+    std::atomic<size_t> cachedBytes;
+    std::atomic<uint64_t> nextSequence;
+  };
+}
+
+#endif
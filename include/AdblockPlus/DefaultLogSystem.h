@@ -28,8 +28,22 @@ namespace AdblockPlus
   class DefaultLogSystem : public LogSystem
   {
   public:
+    /**
+     * Constructor.
+     * @param minLogLevel Messages below this level are dropped.
+     * @param includeSource Whether to write the source of messages.
+     */
+    explicit DefaultLogSystem(LogLevel minLogLevel = LOG_LEVEL_TRACE,
+                              bool includeSource = true);
+
     void operator()(LogLevel logLevel, const std::string& message,
           const std::string& source);
+    bool IsEnabled(LogLevel logLevel) const;
+    bool NeedsSource() const;
+
+  private:
+    const LogLevel minLogLevel;
+    const bool includeSource;
   };
 }
 
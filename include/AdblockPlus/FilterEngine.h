@@ -18,12 +18,17 @@
 #ifndef ADBLOCK_PLUS_FILTER_ENGINE_H
 #define ADBLOCK_PLUS_FILTER_ENGINE_H
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include <AdblockPlus/JsEngine.h>
 #include <AdblockPlus/JsValue.h>
+#include <AdblockPlus/LatencyHistogram.h>
 #include <AdblockPlus/Notification.h>
 
 namespace AdblockPlus
@@ -51,7 +56,22 @@ namespace AdblockPlus
      * Retrieves the type of this filter.
      * @return Type of this filter.
      */
-    Type GetType();
+    Type GetType() const;
+
+    /**
+     * Retrieves the text of this filter.
+     * @return Text of this filter.
+     */
+    const std::string& GetText() const;
+
+    /**
+     * Retrieves the ID of this filter, see FilterEngine::GetFilterText() and
+     * related functions for lookups by ID.
+     * Filters are assigned an ID when they are created or loaded, the ID
+     * doesn't change when the filter is added to or removed from lists.
+     * @return ID of this filter, unique within a `FilterEngine`.
+     */
+    int GetId();
 
     /**
      * Checks whether this filter has been added to the list of custom filters.
@@ -78,6 +98,16 @@ namespace AdblockPlus
      * @param value JavaScript filter object.
      */
 	Filter(JsValue&& value);
+
+  private:
+    friend class FilterEngine;
+
+    // Used by FilterEngine, which already knows the type and text
+    Filter(JsValue&& value, Type type, const std::string& text);
+
+    // Filters are immutable, these are read once on construction
+    Type type;
+    std::string text;
   };
 
   /**
@@ -139,6 +169,150 @@ namespace AdblockPlus
    */
   typedef std::shared_ptr<Subscription> SubscriptionPtr;
 
+  /**
+   * Outcome of a filter match, see
+   * FilterEngine::Matches(const std::string&, ContentType, const std::vector<std::string>&, MatchResult&) const.
+   * Unlike `Filter`, this is a plain value without a reference into the
+   * JavaScript engine.
+   */
+  struct MatchResult
+  {
+    /**
+     * Decision taken for the request.
+     */
+    enum Decision {DECISION_NONE, DECISION_BLOCK, DECISION_ALLOW};
+
+    Decision decision;
+
+    /**
+     * Type of the matching filter, `TYPE_INVALID` if there was no match.
+     */
+    Filter::Type filterType;
+
+    /**
+     * ID of the matching filter, `0` if there was no match.
+     * See Filter::GetId().
+     */
+    int filterId;
+
+    /**
+     * Whether blocked content should be collapsed, `false` unless the
+     * request was blocked.
+     */
+    bool collapse;
+
+    /**
+     * Text of the matching filter, `nullptr` if there was no match.
+     * The string is owned by the `FilterEngine` and remains valid for its
+     * lifetime.
+     */
+    const std::string* text;
+  };
+
+  /**
+   * Durations of the phases of creating a `FilterEngine` in microseconds,
+   * see FilterEngine::GetStartupReport(). The scripts load prefs and
+   * filters asynchronously, so these phases are reported as the time from
+   * the start of the constructor until they completed.
+   */
+  struct FilterEngineStartupReport
+  {
+    /**
+     * Phases of creating the `JsEngine` the filter engine uses.
+     */
+    JsEngineStartupReport jsEngine;
+
+    /**
+     * Evaluation time of every JavaScript file, in the order they are
+     * loaded.
+     */
+    std::vector<std::pair<std::string, int64_t> > scriptEvaluation;
+
+    /**
+     * Time until `prefs.json` was read and parsed.
+     */
+    int64_t prefsLoaded;
+
+    /**
+     * Time until `patterns.ini` was read and parsed.
+     */
+    int64_t filtersLoaded;
+
+    /**
+     * Time until all filters were added to the matchers.
+     */
+    int64_t matchersPopulated;
+
+    /**
+     * Time until the scripts reported that initialization is done.
+     */
+    int64_t initialized;
+
+    /**
+     * Total time spent in the constructor.
+     */
+    int64_t total;
+  };
+
+  /**
+   * Call counts and durations of the frequently used operations of a
+   * `FilterEngine`, see FilterEngine::GetStatistics(). Durations include
+   * waiting for the engine lock and are in nanoseconds.
+   */
+  struct FilterEngineStatistics
+  {
+    /**
+     * Calls of all variants of FilterEngine::Matches().
+     */
+    LatencyStatistics matches;
+
+    /**
+     * Single lookups of a URL in the matcher, `Matches()` makes one per
+     * frame in the document chain.
+     */
+    LatencyStatistics checkFilterMatch;
+
+    /**
+     * Calls of FilterEngine::GetElementHidingSelectors().
+     */
+    LatencyStatistics getElementHidingSelectors;
+
+    /**
+     * Calls of FilterEngine::IsDocumentWhitelisted().
+     */
+    LatencyStatistics isDocumentWhitelisted;
+
+    /**
+     * Invocations of the callback set via
+     * FilterEngine::SetFilterChangeCallback().
+     */
+    LatencyStatistics filterChangeCallback;
+
+    /**
+     * Lookups answered from the matcher's result cache and lookups that had
+     * to check the filters.
+     */
+    //@{
+    int64_t matcherCacheHits;
+    int64_t matcherCacheMisses;
+    //@}
+
+    /**
+     * Lookups of natively cached filter properties, e.g. for `MatchResult`,
+     * that were answered from the cache and that had to query the filter.
+     */
+    //@{
+    int64_t filterInfoCacheHits;
+    int64_t filterInfoCacheMisses;
+    //@}
+
+    /**
+     * Statistics of the `JsEngine` the filter engine uses, including the
+     * time spent waiting for and holding the engine lock.
+     */
+    JsEngineStatistics jsEngine;
+  };
+
   /**
    * Main component of libadblockplus.
    * It handles:
@@ -219,14 +393,17 @@ namespace AdblockPlus
      * Retrieves a filter object from its text representation.
      * @param text Text representation of the filter,
      *        see https://adblockplus.org/en/filters.
-     * @return New `Filter` instance.
+     * @return `Filter` instance. Wrappers are reused: as long as a `Filter`
+     *         is referenced, this and other functions return that same
+     *         instance for the same filter.
      */
     FilterPtr GetFilter(const std::string& text);
 
     /**
      * Retrieves a subscription object for the supplied URL.
      * @param url Subscription URL.
-     * @return New `Subscription` instance.
+     * @return `Subscription` instance, reused like the wrappers returned by
+     *         GetFilter().
      */
     SubscriptionPtr GetSubscription(const std::string& url);
 
@@ -236,6 +413,30 @@ namespace AdblockPlus
      */
     std::vector<FilterPtr> GetListedFilters() const;
 
+    /**
+     * Retrieves the number of distinct filters in all subscriptions,
+     * including custom filters.
+     * @return Number of filters.
+     */
+    int GetFilterCount() const;
+
+    /**
+     * Returns how long it took to create this filter engine.
+     * @return Durations of the startup phases.
+     */
+    const FilterEngineStartupReport& GetStartupReport() const
+    {
+      return startupReport;
+    }
+
+    /**
+     * Returns call counts, durations and cache hit counts of the frequently
+     * used operations since this filter engine was created. Counting is
+     * cheap enough to be always enabled.
+     * @return Statistics of this engine.
+     */
+    FilterEngineStatistics GetStatistics() const;
+
     /**
      * Retrieves all subscriptions.
      * @return List of subscriptions.
@@ -298,6 +499,57 @@ namespace AdblockPlus
         ContentType contentType,
         const std::vector<std::string>& documentUrls) const;
 
+    /**
+     * Retrieves the text of a filter.
+     * @param id ID of the filter, see Filter::GetId().
+     * @return Text of the filter. The string is owned by the `FilterEngine`
+     *         and remains valid for its lifetime.
+     * @throw `std::invalid_argument`, if there is no filter with this ID.
+     */
+    const std::string& GetFilterText(int id) const;
+
+    /**
+     * Retrieves the type of a filter.
+     * @param id ID of the filter, see Filter::GetId().
+     * @return Type of the filter.
+     * @throw `std::invalid_argument`, if there is no filter with this ID.
+     */
+    Filter::Type GetFilterType(int id) const;
+
+    /**
+     * Retrieves the subscriptions a filter belongs to.
+     * @param id ID of the filter, see Filter::GetId().
+     * @return URLs of the subscriptions containing the filter.
+     * @throw `std::invalid_argument`, if there is no filter with this ID.
+     */
+    std::vector<std::string> GetFilterSubscriptions(int id) const;
+
+    /**
+     * Retrieves how often a filter matched.
+     * @param id ID of the filter, see Filter::GetId().
+     * @return Hit count of the filter, always `0` for comments and invalid
+     *         filters.
+     * @throw `std::invalid_argument`, if there is no filter with this ID.
+     */
+    int GetFilterHitCount(int id) const;
+
+    /**
+     * Checks if any active filter matches the supplied URL, without creating
+     * a `Filter` wrapper for the result. This is the preferred variant for
+     * applications matching a lot of requests.
+     * @param url URL to match.
+     * @param contentType Content type of the requested resource.
+     * @param documentUrls Chain of documents requesting the resource, see
+     *        Matches(const std::string&, ContentType, const std::vector<std::string>&) const.
+     * @param result Receives the outcome of the match.
+     * @return `true` if a filter matched.
+     * @throw `std::invalid_argument`, if an invalid `contentType` was supplied.
+     */
+    bool Matches(const std::string& url,
+        ContentType contentType,
+        const std::vector<std::string>& documentUrls,
+        MatchResult& result) const;
+
     /**
      * Checks whether the document at the supplied URL is whitelisted.
      * @param url URL of the document.
@@ -422,15 +674,61 @@ namespace AdblockPlus
 
   private:
     JsEnginePtr jsEngine;
-    bool initialized;
+    /// Set by the JavaScript thread once the startup report and `firstRun`
+    /// are complete.
+    std::atomic<bool> initialized;
     bool firstRun;
     int updateCheckId;
+    FilterEngineStartupReport startupReport;
+    std::chrono::steady_clock::time_point constructionStart;
+    /// `API.checkFilterMatchId`, looked up once since it runs for every
+    /// matched request.
+    JsValuePtr checkFilterMatchIdFunc;
     static const std::map<ContentType, std::string> contentTypes;
 
+    /**
+     * Natively cached properties of a filter, indexed by filter ID.
+     */
+    struct FilterInfo
+    {
+      FilterInfo() : loaded(false), type(Filter::TYPE_INVALID), collapse(false) {}
+
+      bool loaded;
+      Filter::Type type;
+      bool collapse;
+      std::string text;
+      std::weak_ptr<Filter> wrapper;
+    };
+
+    typedef std::map<std::string, std::weak_ptr<Subscription> > SubscriptionWrapperMap;
+
+    // Only accessed with the JS engine locked, std::deque keeps references to
+    // existing elements valid when growing.
+    mutable std::deque<FilterInfo> filterInfo;
+    mutable SubscriptionWrapperMap subscriptionWrappers;
+    mutable LatencyHistogram matchesLatency;
+    mutable LatencyHistogram checkFilterMatchLatency;
+    mutable LatencyHistogram elementHidingSelectorsLatency;
+    mutable LatencyHistogram documentWhitelistedLatency;
+    LatencyHistogram filterChangeCallbackLatency;
+    mutable std::atomic<int64_t> filterInfoCacheHits;
+    mutable std::atomic<int64_t> filterInfoCacheMisses;
+
     void InitDone(JsValueList& params);
+    void StartupPhaseDone(JsValueList& params);
     FilterPtr CheckFilterMatch(const std::string& url,
                                ContentType contentType,
                                const std::string& documentUrl) const;
+    int CheckFilterMatchId(const std::string& url,
+                           ContentType contentType,
+                           const std::string& documentUrl) const;
+    const FilterInfo& GetFilterInfo(int id,
+                                   JsValuePtr* filterObject = 0) const;
+    FilterPtr MatchFilter(const std::string& url,
+                          ContentType contentType,
+                          const std::vector<std::string>& documentUrls) const;
+    FilterPtr GetFilterWrapper(int id) const;
+    SubscriptionPtr GetSubscriptionWrapper(const std::string& url) const;
     void UpdateAvailable(UpdateAvailableCallback callback, JsValueList& params);
     void UpdateCheckDone(const std::string& eventName,
                          UpdateCheckDoneCallback callback, JsValueList& params);
@@ -18,23 +18,28 @@
 #ifndef ADBLOCK_PLUS_JS_ENGINE_H
 #define ADBLOCK_PLUS_JS_ENGINE_H
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include <AdblockPlus/AppInfo.h>
 #include <AdblockPlus/LogSystem.h>
 #include <AdblockPlus/FileSystem.h>
 #include <AdblockPlus/JsValue.h>
+#include <AdblockPlus/LatencyHistogram.h>
 #include <AdblockPlus/WebRequest.h>
 
 namespace v8
 {
   class Arguments;
   class Isolate;
+  class String;
   class Value;
   class Context;
+  class FunctionTemplate;
   template<class T> class Handle;
   template<typename T> class FunctionCallbackInfo;
   typedef void(*FunctionCallback)(const FunctionCallbackInfo<v8::Value>& info);
@@ -42,13 +47,44 @@ namespace v8
 
 namespace AdblockPlus
 {
+  class GcScheduler;
+  class JsContext;
   class JsEngine;
+  class PendingTask;
 
   /**
    * Shared smart pointer to a `JsEngine` instance.
    */
   typedef std::shared_ptr<JsEngine> JsEnginePtr;
 
+  /**
+   * Limits for the heap of a V8 isolate. Sizes are in megabytes, 0 keeps the
+   * V8 default.
+   */
+  struct ResourceConstraints
+  {
+    /**
+     * Maximum size of each of the two semi-spaces of the young generation.
+     */
+    int maxSemiSpaceSize;
+
+    /**
+     * Maximum size of the old generation. Exceeding it is fatal, so this
+     * should leave room for the filter lists in use.
+     */
+    int maxOldSpaceSize;
+
+    /**
+     * Maximum size of the space holding compiled code.
+     */
+    int maxExecutableSize;
+
+    ResourceConstraints()
+      : maxSemiSpaceSize(0), maxOldSpaceSize(0), maxExecutableSize(0)
+    {
+    }
+  };
+
   /**
    * Scope based isolate manager. Creates a new isolate instance on
    * constructing and disposes it on destructing.
@@ -56,7 +92,12 @@ namespace AdblockPlus
   class ScopedV8Isolate
   {
   public:
-	  ScopedV8Isolate();
+	  /**
+	   * Creates a new isolate.
+	   * @param constraints Heap limits for the isolate.
+	   */
+	  explicit ScopedV8Isolate(
+	      const ResourceConstraints& constraints = ResourceConstraints());
 	  ~ScopedV8Isolate();
 	  v8::Isolate* GetIsolate()
 	  {
@@ -71,6 +112,85 @@ namespace AdblockPlus
 */
 typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
 
+  /**
+   * Heap and resource usage of a `JsEngine`, see `JsEngine::GetStatistics()`.
+   */
+  struct JsEngineStatistics
+  {
+    /**
+     * Statistics of the V8 heap in bytes. The heap belongs to the isolate,
+     * engines sharing an isolate report the same values.
+     */
+    //@{
+    size_t totalHeapSize;
+    size_t totalHeapSizeExecutable;
+    size_t totalPhysicalSize;
+    size_t usedHeapSize;
+    size_t heapSizeLimit;
+    //@}
+
+    /**
+     * Number of `JsValue` instances currently referring to the engine, each
+     * of them keeps a V8 handle alive.
+     */
+    int64_t liveValues;
+
+    /**
+     * Number of `setTimeout()` calls that did not run yet.
+     */
+    int pendingTimers;
+
+    /**
+     * Number of web requests and file system operations in progress, each
+     * of them runs on its own thread.
+     */
+    int pendingIoThreads;
+
+    /**
+     * Pauses caused by garbage collection slices run by the idle GC
+     * scheduler and `JsEngine::Gc()`.
+     */
+    LatencyStatistics gcPauses;
+
+    /**
+     * Number of times the engine was locked, the total time spent waiting
+     * for the lock and the total time the lock was held in microseconds.
+     * Operations on an engine that is already locked by the current thread,
+     * e.g. within a `JsEngine::Scope`, don't count as locking it again.
+     */
+    //@{
+    int64_t lockCount;
+    int64_t lockWaitTime;
+    int64_t lockHoldTime;
+    //@}
+  };
+
+  /**
+   * Durations of the phases of `JsEngine::New()` in microseconds, see
+   * `JsEngine::GetStartupReport()`.
+   */
+  struct JsEngineStartupReport
+  {
+    /**
+     * Initialization of V8 itself, only done for the first engine.
+     */
+    int64_t v8Initialization;
+
+    /**
+     * Creation of the isolate, `0` if an existing isolate was passed in.
+     */
+    int64_t isolateCreation;
+
+    /**
+     * Creation of the context.
+     */
+    int64_t contextCreation;
+
+    /**
+     * Setup of the global objects, e.g. `_fileSystem` and `console`.
+     */
+    int64_t globalSetup;
+  };
 
   /**
    * JavaScript engine used by `FilterEngine`, wraps v8.
@@ -79,6 +199,8 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
   {
     friend class JsValue;
     friend class JsContext;
+    friend class PendingTask;
+    friend class GcScheduler;
 
   public:
     /**
@@ -91,6 +213,44 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
      */
     typedef std::map<std::string, EventCallback> EventMap;
 
+    /**
+     * Keeps the engine locked for the current thread while it exists.
+     * Every `JsEngine` and `JsValue` operation has to lock the engine, hold a
+     * `Scope` to perform a sequence of operations under a single lock.
+     * Other threads trying to use the engine will block in the meantime, so
+     * scopes should be short-lived. Scopes can be nested. A scope keeps
+     * the engine alive.
+     */
+    class Scope
+    {
+    public:
+      /**
+       * Locks the engine.
+       * @param jsEngine Engine to lock.
+       */
+      explicit Scope(const JsEnginePtr& jsEngine);
+
+      /**
+       * Unlocks the engine, unless an outer scope still holds it.
+       */
+      ~Scope();
+
+    private:
+      Scope(const Scope&);
+      Scope& operator=(const Scope&);
+
+      std::unique_ptr<JsContext> context;
+    };
+
+    /**
+     * Severity of a low memory condition, see `NotifyMemoryPressure()`.
+     */
+    enum MemoryPressureLevel
+    {
+      MEMORY_PRESSURE_MODERATE,
+      MEMORY_PRESSURE_CRITICAL
+    };
+
     /**
      * Creates a new JavaScript engine instance.
      * @param appInfo Information about the app.
@@ -98,6 +258,15 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
      */
 	static JsEnginePtr New(const AppInfo& appInfo = AppInfo(), const ScopedV8IsolatePtr& isolate = ScopedV8IsolatePtr());
 
+    /**
+     * Creates a new JavaScript engine instance with its own isolate.
+     * @param appInfo Information about the app.
+     * @param constraints Heap limits for the new isolate.
+     * @return New `JsEngine` instance.
+     */
+    static JsEnginePtr New(const AppInfo& appInfo,
+        const ResourceConstraints& constraints);
+
     /**
      * Registers the callback function for an event.
      * @param eventName Event name. Note that this can be any string - it's a
@@ -130,10 +299,59 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
         const std::string& filename = "");
 
     /**
-     * Initiates a garbage collection.
+     * Stops the idle GC scheduler, if enabled, and detaches the engine
+     * from its context.
+     */
+    ~JsEngine();
+
+    /**
+     * Performs a full garbage collection, blocking the engine until done.
+     * Use `EnableIdleGc()` to avoid blocking callers.
      */
     void Gc();
 
+    /**
+     * Collects garbage on a background thread whenever the engine hasn't
+     * been used for a while. Garbage is collected in short slices, the
+     * engine is unlocked between slices and collection stops as soon as the
+     * engine is used again. Engines sharing an isolate should only enable
+     * this for one of them.
+     * @param idleTimeMs Milliseconds without any use of the engine after
+     *        which garbage is collected.
+     * @param sliceTimeMs Time V8 is given per slice, in milliseconds.
+     */
+    void EnableIdleGc(int idleTimeMs = 1000, int sliceTimeMs = 5);
+
+    /**
+     * Stops collecting garbage while idle, see `EnableIdleGc()`.
+     */
+    void DisableIdleGc();
+
+    /**
+     * Returns the current heap and resource usage of the engine.
+     * @return Statistics of this engine.
+     */
+    JsEngineStatistics GetStatistics();
+
+    /**
+     * Returns how long it took to create the engine.
+     * @return Durations of the startup phases.
+     */
+    const JsEngineStartupReport& GetStartupReport() const
+    {
+      return startupReport;
+    }
+
+    /**
+     * Releases memory in response to a low memory condition. Scripts can drop
+     * their caches by defining a global `_onMemoryPressure()` function, it is
+     * called with the level (`"moderate"` or `"critical"`) before V8 is
+     * notified. On critical pressure V8 performs a full garbage collection,
+     * which can take a while.
+     * @param level Severity of the condition.
+     */
+    void NotifyMemoryPressure(MemoryPressureLevel level);
+
     //@{
     /**
      * Creates a new JavaScript value.
@@ -169,18 +387,19 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
      * Creates a JavaScript function that invokes a C++ callback.
      * @param callback C++ callback to invoke. The callback receives a
      *        `v8::Arguments` object and can use `FromArguments()` to retrieve
-     *        the current `JsEngine`.
+     *        the current `JsEngine`. The function template is created once
+     *        per engine and callback, so repeated calls return the same
+     *        JavaScript function.
      * @return New `JsValue` instance.
      */
 	JsValuePtr NewCallback(v8::FunctionCallback callback);
 
     /**
-     * Returns a `JsEngine` instance contained in a `v8::Arguments` object.
+     * Returns the `JsEngine` instance a callback is invoked from.
      * Use this in callbacks created via `NewCallback()` to retrieve the current
-     * `JsEngine`.
-     * @param arguments `v8::Arguments` object containing the `JsEngine`
-     *        instance.
-     * @return `JsEngine` instance from `v8::Arguments`.
+     * `JsEngine`, it is looked up in the embedder data of the calling context.
+     * @param arguments `v8::Arguments` object passed to the callback.
+     * @return `JsEngine` instance the callback is running in.
      */
 	static JsEnginePtr FromArguments(const v8::FunctionCallbackInfo<v8::Value>& arguments);
 
@@ -249,6 +468,21 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
 
   private:
 	explicit JsEngine(const ScopedV8IsolatePtr& isolate);
+
+    /**
+     * Runs a single garbage collection step, recording the pause. Locks the
+     * engine without counting as activity, see `EnableIdleGc()`.
+     * @param idleTimeMs Time V8 is given, in milliseconds.
+     * @return `true` if there is nothing left to collect.
+     */
+    bool CollectGarbageSlice(int idleTimeMs);
+
+    /**
+     * Returns the internalized string for a registered property name,
+     * creating it on first use. Must be called with the engine locked.
+     */
+    v8::Local<v8::String> GetPropertyName(const PropertyName& name);
+
 	/// Isolate must be disposed only after disposing of all objects which are
 	/// using it.
 	ScopedV8IsolatePtr isolate;
@@ -259,6 +493,30 @@ typedef std::shared_ptr<ScopedV8Isolate> ScopedV8IsolatePtr;
 	std::unique_ptr<v8::UniquePersistent<v8::Context>> context;
     EventMap eventCallbacks;
     JsValuePtr globalJsObject;
+    std::atomic<int64_t> liveValues;
+    std::atomic<int> pendingTimers;
+    std::atomic<int> pendingIoThreads;
+    /// Incremented whenever the engine is locked, only ever modified with
+    /// the engine locked.
+    std::atomic<uint32_t> activityCount;
+    /// Only accessed with the engine locked, the times are in nanoseconds.
+    int64_t lockCount;
+    int64_t lockWaitTime;
+    int64_t lockHoldTime;
+    /// Number of non-nested `JsContext` instances currently locking the
+    /// engine, more than one if another engine sharing the isolate was
+    /// entered in between.
+    int lockDepth;
+    LatencyHistogram gcPauses;
+    JsEngineStartupReport startupReport;
+    std::unique_ptr<GcScheduler> gcScheduler;
+    /// Indexed by `PropertyName::GetIndex()`, only accessed with the engine
+    /// locked.
+    std::vector<std::unique_ptr<v8::UniquePersistent<v8::String>>> propertyNames;
+    /// Function templates created by `NewCallback()`, only accessed with the
+    /// engine locked.
+    std::map<v8::FunctionCallback,
+        std::unique_ptr<v8::UniquePersistent<v8::FunctionTemplate>>> callbackTemplates;
   };
 }
 
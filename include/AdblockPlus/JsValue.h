@@ -18,6 +18,7 @@
 #ifndef ADBLOCK_PLUS_JS_VALUE_H
 #define ADBLOCK_PLUS_JS_VALUE_H
 
+#include <map>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -25,6 +26,7 @@
 
 namespace v8
 {
+  class String;
   class Value;
   template<class T> class Handle;
   template<class T> class Local;
@@ -35,6 +37,7 @@ namespace AdblockPlus
 {
   class JsValue;
   class JsEngine;
+  template<typename T> class PoolAllocator;
 
   typedef std::shared_ptr<JsEngine> JsEnginePtr;
 
@@ -48,6 +51,44 @@ namespace AdblockPlus
    */
   typedef std::vector<AdblockPlus::JsValuePtr> JsValueList;
 
+  /**
+   * Property name registered once per process, for frequently accessed
+   * properties. Each engine only creates the corresponding JavaScript string
+   * once, the `GetProperty()` and `SetProperty()` overloads taking a
+   * `PropertyName` then skip creating and internalizing the name.
+   * Instances are meant to be static:
+   *
+   *     static const AdblockPlus::PropertyName statusName("status");
+   *     object->SetProperty(statusName, 200);
+   */
+  class PropertyName
+  {
+  public:
+    /**
+     * Registers a property name.
+     * @param name Property name.
+     */
+    explicit PropertyName(const std::string& name);
+
+    const std::string& GetName() const
+    {
+      return name;
+    }
+
+    /**
+     * Returns the index of this property name, unique within the process.
+     * @return Index of this property name.
+     */
+    size_t GetIndex() const
+    {
+      return index;
+    }
+
+  private:
+    std::string name;
+    size_t index;
+  };
+
   /**
    * Wrapper for JavaScript values.
    * See `JsEngine` for creating `JsValue` objects.
@@ -55,6 +96,7 @@ namespace AdblockPlus
   class JsValue
   {
     friend class JsEngine;
+    template<typename T> friend class PoolAllocator;
   public:
 	  JsValue(JsValue&& src);
     virtual ~JsValue();
@@ -72,6 +114,27 @@ namespace AdblockPlus
     bool AsBool() const;
     JsValueList AsList() const;
 
+    /**
+     * Converts an array (see `IsArray()`) to a list of strings, without
+     * wrapping each element in a `JsValue` first.
+     * @return Elements of the array converted to strings.
+     */
+    std::vector<std::string> AsStringVector() const;
+
+    /**
+     * Converts an array (see `IsArray()`) to a list of integers, without
+     * wrapping each element in a `JsValue` first.
+     * @return Elements of the array converted to integers.
+     */
+    std::vector<int64_t> AsInt64Vector() const;
+
+    /**
+     * Converts an object (see `IsObject()`) to a map from its own property
+     * names to the property values converted to strings.
+     * @return Map of property names to values.
+     */
+    std::map<std::string, std::string> AsStringMap() const;
+
     /**
      * Returns a list of property names if this is an object (see `IsObject()`).
      * @return List of property names.
@@ -86,13 +149,24 @@ namespace AdblockPlus
      */
     JsValuePtr GetProperty(const std::string& name) const;
 
+    /**
+     * Returns a property value if this is an object (see `IsObject()`).
+     * @param name Registered property name.
+     * @return Property value, undefined (see `IsUndefined()`) if the property
+     *         does not exist.
+     */
+    JsValuePtr GetProperty(const PropertyName& name) const;
+
     //@{
     /**
      * Sets a property value if this is an object (see `IsObject()`).
+     * Passing a string as an rvalue lets large ASCII buffers be handed to
+     * JavaScript without copying them.
      * @param name Property name.
      * @param val Property value.
      */
     void SetProperty(const std::string& name, const std::string& val);
+    void SetProperty(const std::string& name, std::string&& val);
     void SetProperty(const std::string& name, int64_t val);
     void SetProperty(const std::string& name, bool val);
     void SetProperty(const std::string& name, const JsValuePtr& value);
@@ -106,6 +180,27 @@ namespace AdblockPlus
     }
     //@}
 
+    //@{
+    /**
+     * Sets a property value if this is an object (see `IsObject()`).
+     * @param name Registered property name.
+     * @param val Property value.
+     */
+    void SetProperty(const PropertyName& name, const std::string& val);
+    void SetProperty(const PropertyName& name, std::string&& val);
+    void SetProperty(const PropertyName& name, int64_t val);
+    void SetProperty(const PropertyName& name, bool val);
+    void SetProperty(const PropertyName& name, const JsValuePtr& value);
+    inline void SetProperty(const PropertyName& name, const char* val)
+    {
+      SetProperty(name, std::string(val));
+    }
+    inline void SetProperty(const PropertyName& name, int val)
+    {
+      SetProperty(name, static_cast<int64_t>(val));
+    }
+    //@}
+
     /**
      * Returns the value's class name, e.g.\ _Array_ for arrays
      * (see `IsArray()`).
@@ -129,8 +224,14 @@ namespace AdblockPlus
     JsEnginePtr jsEngine;
   private:
     JsValue(JsEnginePtr jsEngine, v8::Handle<v8::Value> value);
+    static JsValuePtr Create(const JsEnginePtr& jsEngine,
+        v8::Handle<v8::Value> value);
+    JsValuePtr GetProperty(v8::Handle<v8::String> name) const;
     void SetProperty(const std::string& name, v8::Handle<v8::Value> val);
-	std::unique_ptr<v8::UniquePersistent<v8::Value>> value;
+    void SetProperty(const PropertyName& name, v8::Handle<v8::Value> val);
+    void SetProperty(v8::Handle<v8::String> name, v8::Handle<v8::Value> val);
+    // Allocated from the engine's handle pool, null if moved from
+    v8::UniquePersistent<v8::Value>* value;
   };
 }
 
@@ -0,0 +1,140 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_LATENCY_HISTOGRAM_H
+#define ADBLOCK_PLUS_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace AdblockPlus
+{
+  /**
+   * Snapshot of a `LatencyHistogram`, all times in nanoseconds.
+   */
+  struct LatencyStatistics
+  {
+    /**
+     * Number of recorded operations.
+     */
+    int64_t count;
+
+    /**
+     * Total and longest duration of the recorded operations.
+     */
+    //@{
+    int64_t totalTime;
+    int64_t maxTime;
+    //@}
+
+    /**
+     * Percentiles of the durations, with a relative error of at most 1/8.
+     */
+    //@{
+    int64_t p50;
+    int64_t p90;
+    int64_t p99;
+    int64_t p999;
+    //@}
+
+    /**
+     * Non-empty buckets of the histogram in ascending order, as pairs of the
+     * largest duration counted by the bucket and the number of operations.
+     */
+    std::vector<std::pair<int64_t, int64_t> > buckets;
+  };
+
+  /**
+   * Histogram of operation durations in the style of HdrHistogram: each
+   * power of two is divided into eight linear buckets, so that any duration
+   * is known with a relative error of at most 1/8.
+   * Recording only updates a few atomic counters with relaxed ordering, it
+   * is cheap enough to stay enabled. The counters are sharded by thread, so
+   * that threads recording concurrently rarely touch the same cache lines.
+   * A snapshot taken while other threads record might be slightly
+   * inconsistent.
+   */
+  class LatencyHistogram
+  {
+  public:
+    /**
+     * Records the time from construction to destruction.
+     */
+    class Scope
+    {
+    public:
+      explicit Scope(LatencyHistogram& histogram);
+      ~Scope();
+
+    private:
+      Scope(const Scope&);
+      Scope& operator=(const Scope&);
+
+      LatencyHistogram& histogram;
+      const std::chrono::steady_clock::time_point start;
+    };
+
+    LatencyHistogram();
+
+    /**
+     * Records a single operation.
+     * @param nanoseconds Duration of the operation. Durations of 2^36 ns
+     *        (about 69 seconds) or more all end up in the last bucket, the
+     *        total and maximum still reflect them exactly.
+     */
+    void Record(int64_t nanoseconds);
+
+    /**
+     * @return Snapshot of the recorded operations.
+     */
+    LatencyStatistics GetStatistics() const;
+
+  private:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 35;
+    static const int BUCKET_COUNT =
+        SUB_BUCKET_COUNT * (MAX_EXPONENT - SUB_BUCKET_BITS + 2);
+    static const int SHARD_BITS = 3;
+    static const int SHARD_COUNT = 1 << SHARD_BITS;
+
+    struct Shard
+    {
+      Shard();
+
+      std::atomic<int64_t> totalTime;
+      std::atomic<int64_t> maxTime;
+      std::atomic<int64_t> buckets[BUCKET_COUNT];
+      // Keeps the counters of neighbouring shards on separate cache lines
+      char padding[64];
+    };
+
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    static int GetBucketIndex(int64_t nanoseconds);
+    static int64_t GetBucketLimit(int index);
+
+    std::unique_ptr<Shard[]> shards;
+  };
+}
+
+#endif
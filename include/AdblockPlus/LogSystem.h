@@ -45,6 +45,31 @@ namespace AdblockPlus
      */
     virtual void operator()(LogLevel logLevel, const std::string& message,
           const std::string& source) = 0;
+
+    /**
+     * Checks whether messages of a log level are written at all. This is
+     * checked before a message is formatted, so that unwanted messages
+     * cost next to nothing.
+     * @param logLevel Log level.
+     * @return `true` if messages of this level should be passed on, the
+     *         default implementation accepts all levels.
+     */
+    virtual bool IsEnabled(LogLevel logLevel) const
+    {
+      return true;
+    }
+
+    /**
+     * Checks whether the source of messages is used. Determining the source
+     * of a message requires capturing a stack trace, which is skipped if
+     * this returns `false`.
+     * @return `true` if the source should be passed on, the default
+     *         implementation always wants it.
+     */
+    virtual bool NeedsSource() const
+    {
+      return true;
+    }
   };
 
   /**
@@ -18,9 +18,11 @@
 #ifndef ADBLOCK_PLUS_REFERRER_MAPPING_H
 #define ADBLOCK_PLUS_REFERRER_MAPPING_H
 
-#include <list>
-#include <map>
+#include <cstddef>
+#include <functional>
+#include <stdint.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace AdblockPlus
@@ -30,17 +32,23 @@ namespace AdblockPlus
    * This can be used to build a chain of referrers for any URL
    * (see `BuildReferrerChain()`), which approximates the frame structure, see
    * FilterEngine::Matches().
+   * When full, the least recently added mappings are dropped first.
    */
   class ReferrerMapping
   {
+    friend class ConcurrentReferrerMapping;
+
   public:
     /**
      * Constructor.
      * @param maxCachedUrls Number of URL mappings to store. The higher the
      *        better - clients typically cache requests, and a single cached
      *        request will break the referrer chain.
+     * @param maxCachedBytes Maximum total length of the stored URLs and
+     *        referrers, 0 for no limit.
      */
-    ReferrerMapping(const int maxCachedUrls = 5000);
+    ReferrerMapping(const int maxCachedUrls = 5000,
+                    const size_t maxCachedBytes = 0);
 
     /**
      * Records the refferer for a URL.
@@ -53,14 +61,67 @@ namespace AdblockPlus
      * Builds a chain of referrers for the supplied URL.
      * This should reconstruct a document's parent frame URLs.
      * @param url URL to build the chain for.
-     * @return List of URLs, starting with `url`.
+     * @return List of URLs, ending with `url`.
      */
     std::vector<std::string> BuildReferrerChain(const std::string& url) const;
 
   private:
+    /// Stored URLs with their reference counts, each URL is only stored
+    /// once no matter how often it is used as URL or referrer.
+    typedef std::unordered_map<std::string, int> StringPool;
+    typedef StringPool::value_type* StringRef;
+
+    struct StringRefHash
+    {
+      size_t operator()(const std::string* str) const
+      {
+        return std::hash<std::string>()(*str);
+      }
+    };
+
+    struct StringRefEqual
+    {
+      bool operator()(const std::string* first, const std::string* second) const
+      {
+        return *first == *second;
+      }
+    };
+
+    /// Mappings form a doubly linked list, from the least to the most
+    /// recently added.
+    struct Entry
+    {
+      StringRef url;
+      StringRef referrer;
+      Entry* previous;
+      Entry* next;
+      /// Position in the order of additions across all shards of a
+      /// `ConcurrentReferrerMapping`, unused otherwise.
+      uint64_t sequence;
+    };
+
+    /// Keyed by the URL stored in the string pool.
+    typedef std::unordered_map<const std::string*, Entry, StringRefHash,
+        StringRefEqual> EntryMap;
+
+    ReferrerMapping(const ReferrerMapping&);
+    ReferrerMapping& operator=(const ReferrerMapping&);
+
+    const std::string* FindReferrer(const std::string& url) const;
+
+    StringRef Intern(const std::string& str);
+    void Release(StringRef str);
+    void Link(Entry& entry);
+    void Unlink(Entry& entry);
+    void RemoveOldest();
+
     const int maxCachedUrls;
-    std::map<std::string, std::string> mapping;
-    std::list<std::string> cachedUrls;
+    const size_t maxCachedBytes;
+    size_t cachedBytes;
+    StringPool strings;
+    EntryMap entries;
+    Entry* oldest;
+    Entry* newest;
   };
 }
 
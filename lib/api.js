@@ -27,14 +27,147 @@ var API = (function()
   var Prefs = require("prefs").Prefs;
   var checkForUpdates = require("updater").checkForUpdates;
   var Notification = require("notification").Notification;
+  var FilterNotifier = require("filterNotifier").FilterNotifier;
+
+  // Type tags read by the native Filter wrapper, keep in sync with
+  // Filter::Type. Subclasses not listed here are reported as invalid.
+  (function(filterClasses)
+  {
+    filterClasses.Filter.prototype._type = 5;
+    filterClasses.BlockingFilter.prototype._type = 0;
+    filterClasses.WhitelistFilter.prototype._type = 1;
+    filterClasses.ElemHideFilter.prototype._type = 2;
+    filterClasses.ElemHideException.prototype._type = 3;
+    filterClasses.CommentFilter.prototype._type = 4;
+  })(require("filterClasses"));
+
+  // Filter IDs are dense integers starting at 1. They are assigned when a
+  // filter is added to FilterStorage (or on first use for filters that never
+  // were) and stay valid as long as the engine exists, the filter objects are
+  // kept alive by this list.
+  var filtersById = [null];
+
+  function getFilterId(filter)
+  {
+    if (!filter._id)
+    {
+      filter._id = filtersById.length;
+      filtersById.push(filter);
+    }
+    return filter._id;
+  }
+
+  function assignFilterIds(subscription)
+  {
+    for (var i = 0; i < subscription.filters.length; i++)
+      getFilterId(subscription.filters[i]);
+  }
+
+  FilterNotifier.addListener(function(action, item)
+  {
+    switch (action)
+    {
+      case "load":
+        FilterStorage.subscriptions.forEach(assignFilterIds);
+        break;
+      case "subscription.added":
+      case "subscription.updated":
+        assignFilterIds(item);
+        break;
+      case "filter.added":
+        getFilterId(item);
+        break;
+    }
+  });
+
+  function getFilterFromText(text)
+  {
+    text = Filter.normalize(text);
+    if (!text)
+      throw "Attempted to create a filter from empty text";
+    return Filter.fromText(text);
+  }
+
+  function getListedFilters()
+  {
+    var filters = {};
+    for (var i = 0; i < FilterStorage.subscriptions.length; i++)
+    {
+      var subscription = FilterStorage.subscriptions[i];
+      if (subscription instanceof SpecialSubscription)
+      {
+        for (var j = 0; j < subscription.filters.length; j++)
+        {
+          var filter = subscription.filters[j];
+          if (!(filter.text in filters))
+            filters[filter.text] = filter;
+        }
+      }
+    }
+    return Object.keys(filters).map(function(k)
+    {
+      return filters[k];
+    });
+  }
+
+  function getListedSubscriptions()
+  {
+    return FilterStorage.subscriptions.filter(function(s)
+    {
+      return !(s instanceof SpecialSubscription)
+    });
+  }
+
+  function getRecommendedSubscriptions()
+  {
+    var subscriptions = require("subscriptions.xml");
+    var result = [];
+    for (var i = 0; i < subscriptions.length; i++)
+    {
+      var subscription = Subscription.fromURL(subscriptions[i].url);
+      subscription.title = subscriptions[i].title;
+      subscription.homepage = subscriptions[i].homepage;
+
+      // These aren't normally properties of a Subscription object
+      subscription.author = subscriptions[i].author;
+      subscription.prefixes = subscriptions[i].prefixes;
+      subscription.specialization = subscriptions[i].specialization;
+      result.push(subscription);
+    }
+    return result;
+  }
+
+  function getSubscriptionUrl(subscription)
+  {
+    return subscription.url;
+  }
+
+  var matcherCacheHits = 0;
+  var matcherCacheMisses = 0;
+
+  function checkFilterMatch(url, contentType, documentUrl)
+  {
+    var requestHost = extractHostFromURL(url);
+    var documentHost = extractHostFromURL(documentUrl);
+    var thirdParty = isThirdParty(requestHost, documentHost);
+    // The matcher only adds a cache entry (or starts over with an empty
+    // cache) if the result wasn't cached yet.
+    var cacheEntries = defaultMatcher.cacheEntries;
+    var filter = defaultMatcher.matchesAny(url, contentType, documentHost,
+                                           thirdParty);
+    if (defaultMatcher.cacheEntries == cacheEntries)
+      matcherCacheHits++;
+    else
+      matcherCacheMisses++;
+    return filter;
+  }
 
   return {
-    getFilterFromText: function(text)
+    getFilterFromText: getFilterFromText,
+
+    getFilterIdFromText: function(text)
     {
-      text = Filter.normalize(text);
-      if (!text)
-        throw "Attempted to create a filter from empty text";
-      return Filter.fromText(text);
+      return getFilterId(getFilterFromText(text));
     },
 
     isListedFilter: function(filter)
@@ -55,26 +188,31 @@ var API = (function()
       FilterStorage.removeFilter(filter);
     },
 
-    getListedFilters: function()
+    getListedFilters: getListedFilters,
+
+    getListedFilterIds: function()
     {
-      var filters = {};
+      return getListedFilters().map(getFilterId);
+    },
+
+    getFilterCount: function()
+    {
+      var seen = [];
+      var count = 0;
       for (var i = 0; i < FilterStorage.subscriptions.length; i++)
       {
-        var subscription = FilterStorage.subscriptions[i];
-        if (subscription instanceof SpecialSubscription)
+        var filters = FilterStorage.subscriptions[i].filters;
+        for (var j = 0; j < filters.length; j++)
         {
-          for (var j = 0; j < subscription.filters.length; j++)
+          var id = getFilterId(filters[j]);
+          if (!seen[id])
           {
-            var filter = subscription.filters[j];
-            if (!(filter.text in filters))
-              filters[filter.text] = filter;
+            seen[id] = true;
+            count++;
           }
         }
       }
-      return Object.keys(filters).map(function(k)
-      {
-        return filters[k];
-      });
+      return count;
     },
 
     getSubscriptionFromUrl: function(url)
@@ -110,31 +248,18 @@ var API = (function()
       return Synchronizer.isExecuting(subscription.url);
     },
 
-    getListedSubscriptions: function()
+    getListedSubscriptions: getListedSubscriptions,
+
+    getListedSubscriptionUrls: function()
     {
-      return FilterStorage.subscriptions.filter(function(s)
-      {
-        return !(s instanceof SpecialSubscription)
-      });
+      return getListedSubscriptions().map(getSubscriptionUrl);
     },
 
-    getRecommendedSubscriptions: function()
+    getRecommendedSubscriptions: getRecommendedSubscriptions,
+
+    getRecommendedSubscriptionUrls: function()
     {
-      var subscriptions = require("subscriptions.xml");
-      var result = [];
-      for (var i = 0; i < subscriptions.length; i++)
-      {
-        var subscription = Subscription.fromURL(subscriptions[i].url);
-        subscription.title = subscriptions[i].title;
-        subscription.homepage = subscriptions[i].homepage;
-
-        // These aren't normally properties of a Subscription object
-        subscription.author = subscriptions[i].author;
-        subscription.prefixes = subscriptions[i].prefixes;
-        subscription.specialization = subscriptions[i].specialization;
-        result.push(subscription);
-      }
-      return result;
+      return getRecommendedSubscriptions().map(getSubscriptionUrl);
     },
 
     showNextNotification: function(url)
@@ -151,12 +276,43 @@ var API = (function()
     {
       Notification.markAsShown(id);
     },
-    checkFilterMatch: function(url, contentType, documentUrl)
+    checkFilterMatch: checkFilterMatch,
+
+    getMatcherCacheStatistics: function()
     {
-      var requestHost = extractHostFromURL(url);
-      var documentHost = extractHostFromURL(documentUrl);
-      var thirdParty = isThirdParty(requestHost, documentHost);
-      return defaultMatcher.matchesAny(url, contentType, documentHost, thirdParty);
+      return [matcherCacheHits, matcherCacheMisses];
+    },
+
+    checkFilterMatchId: function(url, contentType, documentUrl)
+    {
+      var filter = checkFilterMatch(url, contentType, documentUrl);
+      return filter ? getFilterId(filter) : 0;
+    },
+
+    getFilterId: getFilterId,
+
+    getFilterById: function(id)
+    {
+      return filtersById[id] || null;
+    },
+
+    getFilterSubscriptionsById: function(id)
+    {
+      var filter = filtersById[id];
+      if (!filter)
+        return null;
+      return filter.subscriptions.map(function(s)
+      {
+        return s.url;
+      });
+    },
+
+    getFilterHitCountById: function(id)
+    {
+      var filter = filtersById[id];
+      if (!filter)
+        return null;
+      return filter.hitCount || 0;
     },
 
     getElementHidingSelectors: function(domain)
@@ -190,3 +346,12 @@ var API = (function()
     }
   };
 })();
+
+// Called by JsEngine::NotifyMemoryPressure(), drops caches that are rebuilt on
+// demand.
+function _onMemoryPressure(level)
+{
+  var defaultMatcher = require("matcher").defaultMatcher;
+  defaultMatcher.resultCache = Object.create(null);
+  defaultMatcher.cacheEntries = 0;
+}
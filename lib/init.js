@@ -32,6 +32,7 @@ function checkInitialized()
 
 Prefs._initListener = function()
 {
+  _triggerEvent("_startupPhase", "prefs");
   prefsInitDone = true;
   checkInitialized();
 };
@@ -40,7 +41,10 @@ FilterNotifier.addListener(function(action)
 {
   if (action === "load")
   {
+    _triggerEvent("_startupPhase", "filters");
+
     let {FilterStorage} = require("filterStorage");
+    let {Utils} = require("utils");
     if (FilterStorage.firstRun)
     {
       // No data, must be a new user or someone with corrupted data - initialize
@@ -49,7 +53,6 @@ FilterNotifier.addListener(function(action)
       let {Subscription, DownloadableSubscription} = require("subscriptionClasses");
       let {Synchronizer} = require("synchronizer");
       let {Prefs} = require("prefs");
-      let {Utils} = require("utils");
 
       // Choose default subscription and add it
       let subscriptions = require("subscriptions.xml");
@@ -66,7 +69,13 @@ FilterNotifier.addListener(function(action)
       }
     }
 
-    filtersInitDone = true;
-    checkInitialized();
+    // This listener runs before filterListener's, wait until it added the
+    // filters to the matchers.
+    Utils.runAsync(function()
+    {
+      _triggerEvent("_startupPhase", "matchers");
+      filtersInitDone = true;
+      checkInitialized();
+    });
   }
 });
@@ -37,17 +37,23 @@
     ],
     'sources': [
       'src/AppInfoJsObject.cpp',
+      'src/AsyncLogSystem.cpp',
+      'src/ConcurrentReferrerMapping.cpp',
       'src/ConsoleJsObject.cpp',
       'src/DefaultLogSystem.cpp',
       'src/DefaultFileSystem.cpp',
       'src/FileSystemJsObject.cpp',
       'src/FilterEngine.cpp',
+      'src/GcScheduler.cpp',
       'src/GlobalJsObject.cpp',
       'src/JsContext.cpp',
       'src/JsEngine.cpp',
       'src/JsError.cpp',
       'src/JsValue.cpp',
+      'src/LatencyHistogram.cpp',
+      'src/MemoryPool.cpp',
       'src/Notification.cpp',
+      'src/PendingTask.cpp',
       'src/ReferrerMapping.cpp',
       'src/Thread.cpp',
       'src/Utils.cpp',
@@ -166,6 +172,8 @@
 	  'test/BaseJsTest.h',
 	  'test/BaseJsTest.cpp',
       'test/AppInfoJsObject.cpp',
+      'test/AsyncLogSystem.cpp',
+      'test/ConcurrentReferrerMapping.cpp',
       'test/ConsoleJsObject.cpp',
       'test/DefaultFileSystem.cpp',
       'test/FileSystemJsObject.cpp',
@@ -173,6 +181,8 @@
       'test/GlobalJsObject.cpp',
       'test/JsEngine.cpp',
       'test/JsValue.cpp',
+      'test/LatencyHistogram.cpp',
+      'test/MemoryPool.cpp',
       'test/Notification.cpp',
       'test/Prefs.cpp',
       'test/ReferrerMapping.cpp',
@@ -186,5 +196,43 @@
         'EntryPointSymbol': 'mainCRTStartup',
       },
     },
+  },
+  {
+    'target_name': 'benchmarks',
+    'type': 'executable',
+    'dependencies': [
+      'libadblockplus'
+    ],
+    'sources': [
+      'benchmark/AllocationCounter.cpp',
+      'benchmark/BaseBenchmark.h',
+      'benchmark/Benchmark.cpp',
+      'benchmark/Benchmark.h',
+      'benchmark/FilterData.cpp',
+      'benchmark/FilterData.h',
+      'benchmark/JsEngine.cpp',
+      'benchmark/JsValue.cpp',
+      'benchmark/Matching.cpp',
+      'benchmark/Memory.cpp',
+      'benchmark/MemoryPool.cpp',
+      'benchmark/ReferrerMapping.cpp',
+      'benchmark/Startup.cpp',
+      'benchmark/Update.cpp'
+    ],
+    'conditions': [
+      ['OS=="win"',
+        {
+          'link_settings': {
+            'libraries': [ '-lpsapi.lib' ]
+          }
+        }
+      ]
+    ],
+    'msvs_settings': {
+      'VCLinkerTool': {
+        'SubSystem': '1',   # Console
+        'EntryPointSymbol': 'mainCRTStartup',
+      },
+    },
   }]
 }
@@ -15,8 +15,6 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <iostream>
-
 #include "Command.h"
 
 Command::Command(const std::string& name) : name(name)
@@ -29,10 +27,15 @@ Command::~Command()
 
 void Command::ShowUsage() const
 {
-  std::cout << "Usage: " << GetUsage() << std::endl;
+  throw CommandError("Usage: " + GetUsage());
+}
+
+CommandError::CommandError(const std::string& message)
+  : std::runtime_error(message)
+{
 }
 
 NoSuchCommandError::NoSuchCommandError(const std::string& commandName)
-  : std::runtime_error("No such command: " + commandName)
+  : CommandError("No such command: " + commandName)
 {
 }
@@ -34,12 +34,25 @@ public:
   virtual std::string GetUsage() const = 0;
 
 protected:
+  /**
+   * Aborts the command with a `CommandError` showing its usage.
+   */
   void ShowUsage() const;
 };
 
 typedef std::map<const std::string, Command*> CommandMap;
 
-class NoSuchCommandError : public std::runtime_error
+/**
+ * Thrown by commands that failed, the shell shows the message and exits
+ * with a non-zero status if the command was passed on the command line.
+ */
+class CommandError : public std::runtime_error
+{
+public:
+  explicit CommandError(const std::string& message);
+};
+
+class NoSuchCommandError : public CommandError
 {
 public:
   explicit NoSuchCommandError(const std::string& commandName);
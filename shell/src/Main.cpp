@@ -16,18 +16,34 @@
  */
 
 #include <AdblockPlus.h>
+#include <chrono>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 #include "GcCommand.h"
 #include "HelpCommand.h"
 #include "FiltersCommand.h"
 #include "MatchesCommand.h"
+#include "MemoryCommand.h"
 #include "PrefsCommand.h"
+#include "ReplayCommand.h"
+#include "StatsCommand.h"
 #include "SubscriptionsCommand.h"
 
 namespace
 {
+  // Longest time to wait for subscription downloads when running a single
+  // command, in seconds.
+  const int UPDATE_TIMEOUT = 120;
+
+  // Commands run from the command line that are pointless without filters,
+  // the shell waits for subscription downloads before running them.
+  bool NeedsFilters(const std::string& commandName)
+  {
+    return commandName == "matches" || commandName == "replay";
+  }
+
   void Add(CommandMap& commands, Command* command)
   {
     commands[command->name] = command;
@@ -49,9 +65,52 @@ namespace
     lineStream >> name;
     std::getline(lineStream, arguments);
   }
+
+  bool RunCommand(const CommandMap& commands, const std::string& commandLine)
+  {
+    std::string commandName;
+    std::string arguments;
+    ParseCommandLine(commandLine, commandName, arguments);
+    const CommandMap::const_iterator it = commands.find(commandName);
+    try
+    {
+      if (it != commands.end())
+        (*it->second)(arguments);
+      else
+        throw NoSuchCommandError(commandName);
+    }
+    catch (const CommandError& error)
+    {
+      std::cout << error.what() << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // On first run the default subscription is only being downloaded once the
+  // filter engine has been created.
+  bool WaitForSubscriptionUpdates(AdblockPlus::FilterEngine& filterEngine)
+  {
+    const std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::seconds(UPDATE_TIMEOUT);
+    const std::vector<AdblockPlus::SubscriptionPtr> subscriptions =
+        filterEngine.GetListedSubscriptions();
+    for (std::vector<AdblockPlus::SubscriptionPtr>::const_iterator it =
+         subscriptions.begin(); it != subscriptions.end(); ++it)
+    {
+      while ((*it)->IsUpdating())
+      {
+        if (std::chrono::steady_clock::now() >= deadline)
+          return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+    }
+    return true;
+  }
 }
 
-int main()
+int main(int argc, char* argv[])
 {
   try
   {
@@ -62,6 +121,7 @@ int main()
     appInfo.applicationVersion = "1.0";
     appInfo.locale = "en-US";
     AdblockPlus::JsEnginePtr jsEngine(AdblockPlus::JsEngine::New(appInfo));
+    jsEngine->EnableIdleGc();
     AdblockPlus::FilterEngine filterEngine(jsEngine);
 
     CommandMap commands;
@@ -70,31 +130,36 @@ int main()
     Add(commands, new FiltersCommand(filterEngine));
     Add(commands, new SubscriptionsCommand(filterEngine));
     Add(commands, new MatchesCommand(filterEngine));
+    Add(commands, new MemoryCommand(jsEngine, filterEngine));
     Add(commands, new PrefsCommand(filterEngine));
+    Add(commands, new ReplayCommand(appInfo, filterEngine));
+    Add(commands, new StatsCommand(filterEngine));
 
-    std::string commandLine;
-    while (ReadCommandLine(commandLine))
+    // Run a command passed on the command line and exit, e.g.
+    // `abpshell replay requests.log 4`.
+    if (argc > 1)
     {
-      std::string commandName;
-      std::string arguments;
-      ParseCommandLine(commandLine, commandName, arguments);
-      const CommandMap::const_iterator it = commands.find(commandName);
-      try
+      if (NeedsFilters(argv[1]) && !WaitForSubscriptionUpdates(filterEngine))
       {
-        if (it != commands.end())
-          (*it->second)(arguments);
-        else
-          throw NoSuchCommandError(commandName);
-      }
-      catch (NoSuchCommandError error)
-      {
-        std::cout << error.what() << std::endl;
+        std::cerr << "Timed out waiting for subscription downloads"
+                  << std::endl;
+        return 1;
       }
+
+      std::string commandLine(argv[1]);
+      for (int i = 2; i < argc; i++)
+        commandLine += std::string(" ") + argv[i];
+      return RunCommand(commands, commandLine) ? 0 : 1;
     }
+
+    std::string commandLine;
+    while (ReadCommandLine(commandLine))
+      RunCommand(commands, commandLine);
   }
   catch (const std::exception& e)
   {
     std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
   }
   return 0;
 }
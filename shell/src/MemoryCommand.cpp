@@ -0,0 +1,56 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#include "MemoryCommand.h"
+
+MemoryCommand::MemoryCommand(AdblockPlus::JsEnginePtr jsEngine,
+                             AdblockPlus::FilterEngine& filterEngine)
+  : Command("memory"), jsEngine(jsEngine), filterEngine(filterEngine)
+{
+}
+
+void MemoryCommand::operator()(const std::string& arguments)
+{
+  const AdblockPlus::JsEngineStatistics stats = jsEngine->GetStatistics();
+  std::cout << "Heap size: " << stats.totalHeapSize << std::endl;
+  std::cout << "Executable heap size: " << stats.totalHeapSizeExecutable
+            << std::endl;
+  std::cout << "Physical heap size: " << stats.totalPhysicalSize << std::endl;
+  std::cout << "Used heap size: " << stats.usedHeapSize << std::endl;
+  std::cout << "Heap size limit: " << stats.heapSizeLimit << std::endl;
+  std::cout << "Live values: " << stats.liveValues << std::endl;
+  std::cout << "Pending timers: " << stats.pendingTimers << std::endl;
+  std::cout << "Pending I/O threads: " << stats.pendingIoThreads << std::endl;
+  std::cout << "Filters: " << filterEngine.GetFilterCount() << std::endl;
+
+  std::cout << "GC pauses: " << stats.gcPauses.count << ", median "
+            << stats.gcPauses.p50 / 1000 << "us, 99th percentile "
+            << stats.gcPauses.p99 / 1000 << "us, longest "
+            << stats.gcPauses.maxTime / 1000 << "us" << std::endl;
+}
+
+std::string MemoryCommand::GetDescription() const
+{
+  return "Shows heap and resource usage";
+}
+
+std::string MemoryCommand::GetUsage() const
+{
+  return name;
+}
@@ -0,0 +1,376 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "ReplayCommand.h"
+
+namespace
+{
+  typedef AdblockPlus::FilterEngine::ContentType ContentType;
+
+  // Lines handed to a worker at a time, large enough to keep contention on
+  // the reader low.
+  const size_t BATCH_SIZE = 256;
+
+  const size_t TOP_FILTER_COUNT = 10;
+
+  // Lets additional engines load the shell's filter lists and preferences,
+  // without them writing back to the files the shell's engine owns.
+  class ReadOnlyFileSystem : public AdblockPlus::FileSystem
+  {
+  public:
+    explicit ReadOnlyFileSystem(const AdblockPlus::FileSystemPtr& fileSystem)
+      : fileSystem(fileSystem)
+    {
+    }
+
+    std::shared_ptr<std::istream> Read(const std::string& path) const
+    {
+      return fileSystem->Read(path);
+    }
+
+    void Write(const std::string& path, std::shared_ptr<std::istream> data)
+    {
+    }
+
+    void Move(const std::string& fromPath, const std::string& toPath)
+    {
+    }
+
+    void Remove(const std::string& path)
+    {
+    }
+
+    StatResult Stat(const std::string& path) const
+    {
+      return fileSystem->Stat(path);
+    }
+
+    std::string Resolve(const std::string& path) const
+    {
+      return fileSystem->Resolve(path);
+    }
+
+  private:
+    AdblockPlus::FileSystemPtr fileSystem;
+  };
+
+  // Keeps additional engines from downloading subscriptions, they have to
+  // match against the same filters as the shell's engine.
+  class OfflineWebRequest : public AdblockPlus::WebRequest
+  {
+  public:
+    AdblockPlus::ServerResponse GET(const std::string& url,
+        const AdblockPlus::HeaderList& requestHeaders) const
+    {
+      AdblockPlus::ServerResponse response;
+      response.status = NS_ERROR_FAILURE;
+      response.responseStatus = 0;
+      return response;
+    }
+  };
+
+  class LogReader
+  {
+  public:
+    explicit LogReader(const std::string& path) : stream(path.c_str())
+    {
+    }
+
+    bool IsOpen() const
+    {
+      return stream.is_open();
+    }
+
+    bool ReadBatch(std::vector<std::string>& lines)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      lines.clear();
+      std::string line;
+      while (lines.size() < BATCH_SIZE && std::getline(stream, line))
+        lines.push_back(line);
+      return !lines.empty();
+    }
+
+  private:
+    std::ifstream stream;
+    std::mutex mutex;
+  };
+
+  struct ReplayResult
+  {
+    ReplayResult() : blocked(0), whitelisted(0), unmatched(0), skipped(0)
+    {
+    }
+
+    int64_t blocked;
+    int64_t whitelisted;
+    int64_t unmatched;
+    int64_t skipped;
+    // Filter texts are owned by the filter engine a worker uses, there is
+    // one entry per distinct filter text once results are merged.
+    std::unordered_map<const std::string*, int64_t> filterHits;
+    std::string error;
+  };
+
+  bool ParseLine(const std::string& line, std::string& url,
+                 ContentType& contentType, std::vector<std::string>& documentUrls)
+  {
+    std::istringstream lineStream(line);
+    std::string contentTypeStr;
+    std::string documentUrl;
+    lineStream >> url >> contentTypeStr >> documentUrl;
+    if (url.empty() || url[0] == '#' || contentTypeStr.empty())
+      return false;
+
+    std::transform(contentTypeStr.begin(), contentTypeStr.end(),
+        contentTypeStr.begin(), ::toupper);
+    try
+    {
+      contentType = AdblockPlus::FilterEngine::StringToContentType(contentTypeStr);
+    }
+    catch (std::invalid_argument&)
+    {
+      return false;
+    }
+
+    documentUrls.clear();
+    if (!documentUrl.empty())
+      documentUrls.push_back(documentUrl);
+    return true;
+  }
+
+  void Replay(LogReader& reader, const AdblockPlus::FilterEngine& filterEngine,
+              ReplayResult& result)
+  {
+    try
+    {
+      std::vector<std::string> lines;
+      std::string url;
+      ContentType contentType;
+      std::vector<std::string> documentUrls;
+      AdblockPlus::MatchResult match;
+      while (reader.ReadBatch(lines))
+      {
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+          url.clear();
+          if (!ParseLine(lines[i], url, contentType, documentUrls))
+          {
+            if (!url.empty() && url[0] != '#')
+              result.skipped++;
+            continue;
+          }
+
+          if (!filterEngine.Matches(url, contentType, documentUrls, match))
+          {
+            result.unmatched++;
+            continue;
+          }
+          if (match.decision == AdblockPlus::MatchResult::DECISION_BLOCK)
+            result.blocked++;
+          else
+            result.whitelisted++;
+          result.filterHits[match.text]++;
+        }
+      }
+    }
+    catch (const std::exception& e)
+    {
+      result.error = e.what();
+    }
+  }
+
+  bool CompareHits(const std::pair<std::string, int64_t>& a,
+                   const std::pair<std::string, int64_t>& b)
+  {
+    return a.second > b.second;
+  }
+
+  std::string FormatShare(int64_t count, int64_t total)
+  {
+    std::ostringstream share;
+    share << std::fixed << std::setprecision(1)
+          << (total ? 100.0 * count / total : 0.0) << "%";
+    return share.str();
+  }
+}
+
+ReplayCommand::ReplayCommand(const AdblockPlus::AppInfo& appInfo,
+                             AdblockPlus::FilterEngine& filterEngine)
+  : Command("replay"), appInfo(appInfo), filterEngine(filterEngine)
+{
+}
+
+void ReplayCommand::operator()(const std::string& arguments)
+{
+  std::istringstream argumentStream(arguments);
+  std::string path;
+  std::string threadCountStr;
+  std::string engineCountStr;
+  argumentStream >> path >> threadCountStr >> engineCountStr;
+  const int threadCount =
+      threadCountStr.empty() ? 1 : std::atoi(threadCountStr.c_str());
+  const int engineCount =
+      engineCountStr.empty() ? 1 : std::atoi(engineCountStr.c_str());
+  if (!path.size() || threadCount < 1 || engineCount < 1 ||
+      engineCount > threadCount)
+    ShowUsage();
+
+  LogReader reader(path);
+  if (!reader.IsOpen())
+    throw CommandError("Unable to open " + path);
+
+  // The shell's engine is always used, additional engines load the same
+  // filter lists but each has its own JavaScript context, so that threads
+  // using different engines don't contend.
+  const int filterCount = filterEngine.GetFilterCount();
+  std::vector<AdblockPlus::FilterEngine*> engines(1, &filterEngine);
+  std::vector<std::unique_ptr<AdblockPlus::FilterEngine>> additionalEngines;
+  if (engineCount > 1)
+  {
+    const AdblockPlus::FileSystemPtr fileSystem(new ReadOnlyFileSystem(
+        filterEngine.GetJsEngine()->GetFileSystem()));
+    const AdblockPlus::WebRequestPtr webRequest(new OfflineWebRequest());
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int i = 1; i < engineCount; i++)
+    {
+      const AdblockPlus::JsEnginePtr jsEngine =
+          AdblockPlus::JsEngine::New(appInfo);
+      jsEngine->SetFileSystem(fileSystem);
+      jsEngine->SetWebRequest(webRequest);
+      additionalEngines.push_back(std::unique_ptr<AdblockPlus::FilterEngine>(
+          new AdblockPlus::FilterEngine(jsEngine)));
+      engines.push_back(additionalEngines.back().get());
+
+      // The shell's engine might have changed its filters since it last
+      // saved them.
+      const int engineFilterCount =
+          additionalEngines.back()->GetFilterCount();
+      if (engineFilterCount != filterCount)
+      {
+        std::ostringstream message;
+        message << "Engine " << i + 1 << " loaded " << engineFilterCount
+                << " filters instead of " << filterCount;
+        throw CommandError(message.str());
+      }
+    }
+    std::cout << "Started " << engineCount - 1 << " additional engines in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - start).count()
+              << " ms" << std::endl;
+  }
+  std::cout << "Matching against " << filterCount << " filters"
+            << (engineCount > 1 ? " in each engine" : "") << std::endl;
+
+  std::vector<ReplayResult> results(threadCount);
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++)
+    {
+      threads.push_back(std::thread(Replay, std::ref(reader),
+          std::cref(*engines[i % engineCount]), std::ref(results[i])));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+  }
+  const double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  ReplayResult total;
+  bool failed = false;
+  std::map<std::string, int64_t> filterHits;
+  for (std::vector<ReplayResult>::const_iterator it = results.begin();
+       it != results.end(); ++it)
+  {
+    total.blocked += it->blocked;
+    total.whitelisted += it->whitelisted;
+    total.unmatched += it->unmatched;
+    total.skipped += it->skipped;
+    for (std::unordered_map<const std::string*, int64_t>::const_iterator hit =
+         it->filterHits.begin(); hit != it->filterHits.end(); ++hit)
+    {
+      filterHits[*hit->first] += hit->second;
+    }
+    if (!it->error.empty())
+    {
+      std::cout << "Error: " << it->error << std::endl;
+      failed = true;
+    }
+  }
+
+  const int64_t requests = total.blocked + total.whitelisted + total.unmatched;
+  std::ostringstream summary;
+  summary << "Replayed " << requests << " requests in " << std::fixed
+          << std::setprecision(3) << seconds << " s ("
+          << std::setprecision(0) << (seconds > 0 ? requests / seconds : 0)
+          << " requests/s, " << threadCount << " threads, " << engineCount
+          << " engines)";
+  std::cout << summary.str() << std::endl;
+  std::cout << "Blocked:     " << total.blocked << " ("
+            << FormatShare(total.blocked, requests) << ")" << std::endl;
+  std::cout << "Whitelisted: " << total.whitelisted << " ("
+            << FormatShare(total.whitelisted, requests) << ")" << std::endl;
+  std::cout << "No match:    " << total.unmatched << " ("
+            << FormatShare(total.unmatched, requests) << ")" << std::endl;
+  if (total.skipped)
+    std::cout << "Skipped " << total.skipped << " invalid lines" << std::endl;
+
+  if (!filterHits.empty())
+  {
+    std::vector<std::pair<std::string, int64_t>> topFilters(
+        filterHits.begin(), filterHits.end());
+    const size_t topCount = std::min(TOP_FILTER_COUNT, topFilters.size());
+    std::partial_sort(topFilters.begin(), topFilters.begin() + topCount,
+        topFilters.end(), CompareHits);
+    std::cout << "Top filters:" << std::endl;
+    for (size_t i = 0; i < topCount; i++)
+    {
+      std::cout << std::setw(10) << topFilters[i].second << "  "
+                << topFilters[i].first << std::endl;
+    }
+  }
+
+  if (failed)
+    throw CommandError("Replay aborted by errors");
+}
+
+std::string ReplayCommand::GetDescription() const
+{
+  return "Matches all requests in a log file and reports the results";
+}
+
+std::string ReplayCommand::GetUsage() const
+{
+  return name + " FILE [THREADS [ENGINES]]";
+}
@@ -0,0 +1,46 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLAY_COMMAND_H
+#define REPLAY_COMMAND_H
+
+#include <AdblockPlus.h>
+
+#include "Command.h"
+
+/**
+ * Streams a request log through the filter engine and reports throughput,
+ * the decisions taken and the filters that matched most often. Each line of
+ * the log is `URL CONTENT_TYPE [DOCUMENT_URL]`, lines starting with `#` are
+ * ignored. Additional engines read the shell's filter lists and preferences
+ * but never save or download anything.
+ */
+class ReplayCommand : public Command
+{
+public:
+  ReplayCommand(const AdblockPlus::AppInfo& appInfo,
+                AdblockPlus::FilterEngine& filterEngine);
+  void operator()(const std::string& arguments);
+  std::string GetDescription() const;
+  std::string GetUsage() const;
+
+private:
+  const AdblockPlus::AppInfo appInfo;
+  AdblockPlus::FilterEngine& filterEngine;
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "StatsCommand.h"
+
+namespace
+{
+  std::string FormatMicroseconds(int64_t nanoseconds)
+  {
+    std::ostringstream result;
+    result << std::fixed << std::setprecision(1) << nanoseconds / 1000.0;
+    return result.str();
+  }
+
+  void PrintLatency(const std::string& name,
+                    const AdblockPlus::LatencyStatistics& stats)
+  {
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(10) << stats.count
+              << std::setw(10) << FormatMicroseconds(
+                   stats.count ? stats.totalTime / stats.count : 0)
+              << std::setw(10) << FormatMicroseconds(stats.p50)
+              << std::setw(10) << FormatMicroseconds(stats.p90)
+              << std::setw(10) << FormatMicroseconds(stats.p99)
+              << std::setw(10) << FormatMicroseconds(stats.p999)
+              << std::setw(10) << FormatMicroseconds(stats.maxTime)
+              << std::endl;
+  }
+
+  void PrintCache(const std::string& name, int64_t hits, int64_t misses)
+  {
+    std::ostringstream ratio;
+    ratio << std::fixed << std::setprecision(1)
+          << (hits + misses ? 100.0 * hits / (hits + misses) : 0.0) << "%";
+    std::cout << name << ": " << hits << " hits, " << misses << " misses ("
+              << ratio.str() << " hit ratio)" << std::endl;
+  }
+}
+
+StatsCommand::StatsCommand(AdblockPlus::FilterEngine& filterEngine)
+  : Command("stats"), filterEngine(filterEngine)
+{
+}
+
+void StatsCommand::operator()(const std::string& arguments)
+{
+  const AdblockPlus::FilterEngineStatistics stats =
+      filterEngine.GetStatistics();
+  std::cout << std::left << std::setw(28) << "Operation (us)" << std::right
+            << std::setw(10) << "Calls"
+            << std::setw(10) << "Mean"
+            << std::setw(10) << "P50"
+            << std::setw(10) << "P90"
+            << std::setw(10) << "P99"
+            << std::setw(10) << "P99.9"
+            << std::setw(10) << "Max"
+            << std::endl;
+  PrintLatency("Matches", stats.matches);
+  PrintLatency("CheckFilterMatch", stats.checkFilterMatch);
+  PrintLatency("GetElementHidingSelectors", stats.getElementHidingSelectors);
+  PrintLatency("IsDocumentWhitelisted", stats.isDocumentWhitelisted);
+  PrintLatency("Filter change callback", stats.filterChangeCallback);
+
+  PrintCache("Matcher cache", stats.matcherCacheHits,
+      stats.matcherCacheMisses);
+  PrintCache("Filter info cache", stats.filterInfoCacheHits,
+      stats.filterInfoCacheMisses);
+
+  std::cout << "Engine locked " << stats.jsEngine.lockCount << " times, "
+            << "waited " << stats.jsEngine.lockWaitTime << "us, "
+            << "held " << stats.jsEngine.lockHoldTime << "us" << std::endl;
+  std::cout << "Filters: " << filterEngine.GetFilterCount() << std::endl;
+}
+
+std::string StatsCommand::GetDescription() const
+{
+  return "Shows call counts, latencies and cache hit ratios";
+}
+
+std::string StatsCommand::GetUsage() const
+{
+  return name;
+}
@@ -0,0 +1,196 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AdblockPlus/AsyncLogSystem.h>
+
+#include "Thread.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  size_t RoundUpToPowerOfTwo(size_t value)
+  {
+    size_t result = 2;
+    while (result < value)
+      result *= 2;
+    return result;
+  }
+}
+
+class AsyncLogSystem::FlushThread : public Thread
+{
+public:
+  explicit FlushThread(AsyncLogSystem& logSystem)
+    : logSystem(logSystem)
+  {
+  }
+
+  void Run()
+  {
+    while (!logSystem.stopped)
+    {
+      if (logSystem.WritePending())
+      {
+        std::lock_guard<std::mutex> lock(logSystem.mutex);
+        logSystem.messagesWritten.notify_all();
+        continue;
+      }
+
+      // Loggers check waiting after publishing a message, the fences make
+      // sure that either they see it set or we see their message.
+      std::unique_lock<std::mutex> lock(logSystem.mutex);
+      logSystem.waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!logSystem.HasPending() && !logSystem.stopped)
+        logSystem.messagesAvailable.wait(lock);
+      logSystem.waiting.store(false, std::memory_order_relaxed);
+    }
+    logSystem.WritePending();
+    std::lock_guard<std::mutex> lock(logSystem.mutex);
+    logSystem.messagesWritten.notify_all();
+  }
+
+private:
+  AsyncLogSystem& logSystem;
+};
+
+AsyncLogSystem::AsyncLogSystem(const LogSystemPtr& target, size_t capacity)
+  : target(target), capacity(RoundUpToPowerOfTwo(capacity)),
+    buffer(new Message[this->capacity]), enqueuePosition(0),
+    dequeuePosition(0), droppedMessages(0), stopped(false), waiting(false),
+    flushThread(new FlushThread(*this))
+{
+  for (size_t i = 0; i < this->capacity; i++)
+    buffer[i].sequence.store(i, std::memory_order_relaxed);
+  flushThread->Start();
+}
+
+AsyncLogSystem::~AsyncLogSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  messagesAvailable.notify_one();
+  flushThread->Join();
+}
+
+void AsyncLogSystem::operator()(LogLevel logLevel, const std::string& message,
+    const std::string& source)
+{
+  if (!IsEnabled(logLevel))
+    return;
+
+  // Bounded multi-producer queue as described by Dmitry Vyukov: a slot is
+  // claimed by advancing enqueuePosition, its sequence number tells whether
+  // the consumer is done with it.
+  size_t position = enqueuePosition.load(std::memory_order_relaxed);
+  Message* slot;
+  while (true)
+  {
+    slot = &buffer[position & (capacity - 1)];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence == position)
+    {
+      if (enqueuePosition.compare_exchange_weak(position, position + 1,
+          std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (sequence < position)
+    {
+      droppedMessages.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else
+      position = enqueuePosition.load(std::memory_order_relaxed);
+  }
+
+  slot->logLevel = logLevel;
+  slot->message = message;
+  slot->source = source;
+  slot->sequence.store(position + 1, std::memory_order_release);
+
+  // Only lock if the background thread is waiting, taking the mutex makes
+  // sure that it is done checking for messages.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load(std::memory_order_relaxed))
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+    }
+    messagesAvailable.notify_one();
+  }
+}
+
+bool AsyncLogSystem::IsEnabled(LogLevel logLevel) const
+{
+  return target->IsEnabled(logLevel);
+}
+
+bool AsyncLogSystem::NeedsSource() const
+{
+  return target->NeedsSource();
+}
+
+void AsyncLogSystem::Flush()
+{
+  const size_t position = enqueuePosition.load(std::memory_order_relaxed);
+  std::unique_lock<std::mutex> lock(mutex);
+  while (dequeuePosition.load(std::memory_order_acquire) < position)
+    messagesWritten.wait(lock);
+}
+
+int64_t AsyncLogSystem::GetDroppedMessageCount() const
+{
+  return droppedMessages.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogSystem::HasPending() const
+{
+  const size_t position = dequeuePosition.load(std::memory_order_relaxed);
+  return buffer[position & (capacity - 1)].sequence.load(
+      std::memory_order_acquire) == position + 1;
+}
+
+bool AsyncLogSystem::WritePending()
+{
+  bool written = false;
+  size_t position = dequeuePosition.load(std::memory_order_relaxed);
+  while (true)
+  {
+    Message& slot = buffer[position & (capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+      return written;
+
+    try
+    {
+      (*target)(slot.logLevel, slot.message, slot.source);
+    }
+    catch (...)
+    {
+      // There is nobody to report this to on this thread
+    }
+    slot.message.clear();
+    slot.source.clear();
+    slot.sequence.store(position + capacity, std::memory_order_release);
+    dequeuePosition.store(++position, std::memory_order_release);
+    written = true;
+  }
+}
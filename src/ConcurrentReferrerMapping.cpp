@@ -0,0 +1,134 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <limits>
+#include <AdblockPlus/ConcurrentReferrerMapping.h>
+
+using namespace AdblockPlus;
+
+namespace
+{
+  // Same limit as in ReferrerMapping::BuildReferrerChain()
+  const int maxChainLength = 10;
+
+  const uint64_t noSequence = std::numeric_limits<uint64_t>::max();
+}
+
+ConcurrentReferrerMapping::Shard::Shard()
+  // The limits are enforced across all shards
+  : mapping(INT_MAX), oldestSequence(noSequence)
+{
+}
+
+void ConcurrentReferrerMapping::Shard::UpdateOldestSequence()
+{
+  oldestSequence = mapping.oldest ? mapping.oldest->sequence : noSequence;
+}
+
+ConcurrentReferrerMapping::ConcurrentReferrerMapping(const int maxCachedUrls,
+    const size_t maxCachedBytes, const int shardCount)
+  : maxCachedUrls(maxCachedUrls), maxCachedBytes(maxCachedBytes),
+    cachedUrls(0), cachedBytes(0), nextSequence(0)
+{
+  for (int i = 0; i < std::max(shardCount, 1); i++)
+    shards.push_back(std::unique_ptr<Shard>(new Shard));
+}
+
+void ConcurrentReferrerMapping::Add(const std::string& url,
+                                    const std::string& referrer)
+{
+  {
+    Shard& shard = GetShard(url);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const int previousUrls = static_cast<int>(shard.mapping.entries.size());
+    const size_t previousBytes = shard.mapping.cachedBytes;
+    shard.mapping.Add(url, referrer);
+    // The added or updated entry is now the shard's newest one. Sequence
+    // numbers are taken with the shard locked, so they increase from the
+    // oldest to the newest entry of each shard.
+    shard.mapping.newest->sequence = nextSequence++;
+    shard.UpdateOldestSequence();
+    cachedUrls += static_cast<int>(shard.mapping.entries.size()) - previousUrls;
+    cachedBytes += shard.mapping.cachedBytes - previousBytes;
+  }
+
+  // Drop the least recently added URL of all shards. Only one shard is
+  // locked at a time, so there is no lock order to respect.
+  while (IsFull())
+  {
+    Shard* oldestShard = 0;
+    uint64_t oldestSequence = noSequence;
+    for (size_t i = 0; i < shards.size(); i++)
+    {
+      const uint64_t sequence = shards[i]->oldestSequence;
+      if (sequence < oldestSequence)
+      {
+        oldestShard = shards[i].get();
+        oldestSequence = sequence;
+      }
+    }
+    if (!oldestShard)
+      break;
+
+    std::lock_guard<std::mutex> lock(oldestShard->mutex);
+    // Another thread might have changed the shard in the meantime
+    if (!IsFull() || oldestShard->oldestSequence != oldestSequence)
+      continue;
+    const size_t previousBytes = oldestShard->mapping.cachedBytes;
+    oldestShard->mapping.RemoveOldest();
+    oldestShard->UpdateOldestSequence();
+    cachedUrls--;
+    cachedBytes -= previousBytes - oldestShard->mapping.cachedBytes;
+  }
+}
+
+std::vector<std::string> ConcurrentReferrerMapping::BuildReferrerChain(
+  const std::string& url) const
+{
+  std::vector<std::string> referrerChain;
+  referrerChain.push_back(url);
+  for (int i = 0; i < maxChainLength; i++)
+  {
+    const std::string& currentUrl = referrerChain.back();
+    Shard& shard = GetShard(currentUrl);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const std::string* referrer = shard.mapping.FindReferrer(currentUrl);
+    if (!referrer)
+      break;
+    referrerChain.push_back(*referrer);
+  }
+  std::reverse(referrerChain.begin(), referrerChain.end());
+  return referrerChain;
+}
+
+ConcurrentReferrerMapping::Shard& ConcurrentReferrerMapping::GetShard(
+  const std::string& url) const
+{
+  // The shards' hash maps use the low bits of the same hash, so the shard is
+  // picked using the high bits.
+  const size_t hash = std::hash<std::string>()(url);
+  return *shards[(hash >> (sizeof(size_t) * 4)) % shards.size()];
+}
+
+bool ConcurrentReferrerMapping::IsFull() const
+{
+  return cachedUrls > maxCachedUrls ||
+      (maxCachedBytes && cachedBytes > maxCachedBytes);
+}
@@ -29,24 +29,29 @@ namespace
 		const v8::FunctionCallbackInfo<v8::Value>& arguments)
   {
     AdblockPlus::JsEnginePtr jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
-    const AdblockPlus::JsContext context(jsEngine);
-    AdblockPlus::JsValueList converted = jsEngine->ConvertArguments(arguments);
+    AdblockPlus::LogSystemPtr callback = jsEngine->GetLogSystem();
+    if (!callback->IsEnabled(logLevel))
+      return;
 
-    std::stringstream message;
-    for (size_t i = 0; i < converted.size(); i++)
+    std::string message;
+    for (int i = 0; i < arguments.Length(); i++)
     {
       if (i > 0)
-        message << " ";
-      message << converted[i]->AsString();
+        message += ' ';
+      AdblockPlus::Utils::AppendV8String(message, arguments[i]);
     }
 
-    std::stringstream source;
-	v8::Local<v8::StackFrame> frame = v8::StackTrace::CurrentStackTrace(arguments.GetIsolate(), 1)->GetFrame(0);
-    source << AdblockPlus::Utils::FromV8String(frame->GetScriptName());
-    source << ":" << frame->GetLineNumber();
+    std::string source;
+    if (callback->NeedsSource())
+    {
+      v8::Local<v8::StackFrame> frame = v8::StackTrace::CurrentStackTrace(arguments.GetIsolate(), 1)->GetFrame(0);
+      AdblockPlus::Utils::AppendV8String(source, frame->GetScriptName());
+      std::stringstream lineNumber;
+      lineNumber << ":" << frame->GetLineNumber();
+      source += lineNumber.str();
+    }
 
-    AdblockPlus::LogSystemPtr callback = jsEngine->GetLogSystem();
-    (*callback)(logLevel, message.str(), source.str());
+    (*callback)(logLevel, message, source);
 /*    return v8::Undefined();*/
   }
 
@@ -78,8 +83,9 @@ void ErrorCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
 void TraceCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
   {
     AdblockPlus::JsEnginePtr jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
-    const AdblockPlus::JsContext context(jsEngine);
-    AdblockPlus::JsValueList converted = jsEngine->ConvertArguments(arguments);
+    AdblockPlus::LogSystemPtr callback = jsEngine->GetLogSystem();
+    if (!callback->IsEnabled(AdblockPlus::LogSystem::LOG_LEVEL_TRACE))
+      return;
 
     std::stringstream traceback;
 	v8::Local<v8::StackTrace> frames = v8::StackTrace::CurrentStackTrace(arguments.GetIsolate(), 100);
@@ -98,7 +104,6 @@ void TraceCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
       traceback << std::endl;
     }
 
-    AdblockPlus::LogSystemPtr callback = jsEngine->GetLogSystem();
     (*callback)(AdblockPlus::LogSystem::LOG_LEVEL_TRACE, traceback.str(), "");
   }
 }
@@ -18,9 +18,18 @@
 #include <iostream>
 #include <AdblockPlus/DefaultLogSystem.h>
 
+AdblockPlus::DefaultLogSystem::DefaultLogSystem(LogLevel minLogLevel,
+    bool includeSource)
+  : minLogLevel(minLogLevel), includeSource(includeSource)
+{
+}
+
 void AdblockPlus::DefaultLogSystem::operator()(AdblockPlus::LogSystem::LogLevel logLevel,
     const std::string& message, const std::string& source)
 {
+  if (!IsEnabled(logLevel))
+    return;
+
   switch (logLevel)
   {
     case LOG_LEVEL_TRACE:
@@ -39,7 +48,17 @@ void AdblockPlus::DefaultLogSystem::operator()(AdblockPlus::LogSystem::LogLevel
       break;
   }
   std::cerr << message;
-  if (source.size())
+  if (includeSource && source.size())
     std::cerr << " at " << source;
   std::cerr << std::endl;
 }
+
+bool AdblockPlus::DefaultLogSystem::IsEnabled(LogLevel logLevel) const
+{
+  return logLevel >= minLogLevel;
+}
+
+bool AdblockPlus::DefaultLogSystem::NeedsSource() const
+{
+  return includeSource;
+}
@@ -23,6 +23,7 @@
 #include <AdblockPlus/JsValue.h>
 #include "FileSystemJsObject.h"
 #include "JsContext.h"
+#include "PendingTask.h"
 #include "Thread.h"
 #include "Utils.h"
 
@@ -31,12 +32,19 @@ using AdblockPlus::Utils::ThrowException;
 
 namespace
 {
+  const PropertyName contentName("content");
+  const PropertyName errorName("error");
+  const PropertyName existsName("exists");
+  const PropertyName isFileName("isFile");
+  const PropertyName isDirectoryName("isDirectory");
+  const PropertyName lastModifiedName("lastModified");
+
   class IoThread : public Thread
   {
   public:
     IoThread(JsEnginePtr jsEngine, JsValuePtr callback)
       : jsEngine(jsEngine), fileSystem(jsEngine->GetFileSystem()),
-        callback(callback)
+        callback(callback), pendingTask(jsEngine, PendingTask::TYPE_IO_THREAD)
     {
     }
 
@@ -44,6 +52,9 @@ namespace
     JsEnginePtr jsEngine;
     FileSystemPtr fileSystem;
     JsValuePtr callback;
+
+  private:
+    PendingTask pendingTask;
   };
 
   class ReadThread : public IoThread
@@ -75,8 +86,8 @@ namespace
 
       const JsContext context(jsEngine);
       JsValuePtr result = jsEngine->NewObject();
-      result->SetProperty("content", content);
-      result->SetProperty("error", error);
+      result->SetProperty(contentName, std::move(content));
+      result->SetProperty(errorName, error);
       JsValueList params;
       params.push_back(result);
       callback->Call(params);
@@ -231,11 +242,11 @@ namespace
 
       const JsContext context(jsEngine);
       JsValuePtr result = jsEngine->NewObject();
-      result->SetProperty("exists", statResult.exists);
-      result->SetProperty("isFile", statResult.isFile);
-      result->SetProperty("isDirectory", statResult.isDirectory);
-      result->SetProperty("lastModified", statResult.lastModified);
-      result->SetProperty("error", error);
+      result->SetProperty(existsName, statResult.exists);
+      result->SetProperty(isFileName, statResult.isFile);
+      result->SetProperty(isDirectoryName, statResult.isDirectory);
+      result->SetProperty(lastModifiedName, statResult.lastModified);
+      result->SetProperty(errorName, error);
 
       JsValueList params;
       params.push_back(result);
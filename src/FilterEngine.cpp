@@ -23,33 +23,73 @@
 #include <AdblockPlus.h>
 #include "JsContext.h"
 #include "Thread.h"
+#include "Utils.h"
 
 using namespace AdblockPlus;
 
 extern std::string jsSources[];
 
+namespace
+{
+  const PropertyName typeTagName("_type");
+  const PropertyName textName("text");
+  const PropertyName collapseName("collapse");
+
+  Filter::Type ReadFilterType(const JsValue& filter)
+  {
+    // The type tag is set up by api.js, it avoids comparing class names
+    JsValuePtr tag = filter.GetProperty(typeTagName);
+    if (!tag->IsNumber())
+      return Filter::TYPE_INVALID;
+    const int64_t type = tag->AsInt();
+    if (type < Filter::TYPE_BLOCKING || type > Filter::TYPE_INVALID)
+      return Filter::TYPE_INVALID;
+    return static_cast<Filter::Type>(type);
+  }
+
+  JsValuePtr GetFilterById(const JsEnginePtr& jsEngine, int id)
+  {
+    JsValuePtr func = jsEngine->Evaluate("API.getFilterById");
+    JsValueList params;
+    params.push_back(jsEngine->NewValue(id));
+    JsValuePtr filter = func->Call(params);
+    if (filter->IsNull())
+      throw std::invalid_argument("Unknown filter ID");
+    return filter;
+  }
+}
+
 Filter::Filter(JsValue&& value)
 : JsValue(std::move(value))
 {
+  const JsContext context(jsEngine);
   if (!IsObject())
     throw std::runtime_error("JavaScript value is not an object");
+  type = ReadFilterType(*this);
+  text = GetProperty(textName)->AsString();
 }
 
-Filter::Type Filter::GetType()
+Filter::Filter(JsValue&& value, Type type, const std::string& text)
+: JsValue(std::move(value)), type(type), text(text)
 {
-  std::string className = GetClass();
-  if (className == "BlockingFilter")
-    return TYPE_BLOCKING;
-  else if (className == "WhitelistFilter")
-    return TYPE_EXCEPTION;
-  else if (className == "ElemHideFilter")
-    return TYPE_ELEMHIDE;
-  else if (className == "ElemHideException")
-    return TYPE_ELEMHIDE_EXCEPTION;
-  else if (className == "CommentFilter")
-    return TYPE_COMMENT;
-  else
-    return TYPE_INVALID;
+}
+
+Filter::Type Filter::GetType() const
+{
+  return type;
+}
+
+const std::string& Filter::GetText() const
+{
+  return text;
+}
+
+int Filter::GetId()
+{
+  JsValuePtr func = jsEngine->Evaluate("API.getFilterId");
+  JsValueList params;
+  params.push_back(shared_from_this());
+  return static_cast<int>(func->Call(params)->AsInt());
 }
 
 bool Filter::IsListed()
@@ -78,7 +118,7 @@ void Filter::RemoveFromList()
 
 bool Filter::operator==(const Filter& filter) const
 {
-  return GetProperty("text")->AsString() == filter.GetProperty("text")->AsString();
+  return text == filter.text;
 }
 
 Subscription::Subscription(JsValue&& value)
@@ -136,10 +176,15 @@ bool Subscription::operator==(const Subscription& subscription) const
 
 FilterEngine::FilterEngine(JsEnginePtr jsEngine,
                            const FilterEngine::Prefs& preconfiguredPrefs)
-    : jsEngine(jsEngine), initialized(false), firstRun(false), updateCheckId(0)
+    : jsEngine(jsEngine), initialized(false), firstRun(false), updateCheckId(0),
+      startupReport(), constructionStart(std::chrono::steady_clock::now()),
+      filterInfoCacheHits(0), filterInfoCacheMisses(0)
 {
+  startupReport.jsEngine = jsEngine->GetStartupReport();
   jsEngine->SetEventCallback("_init", std::bind(&FilterEngine::InitDone,
       this, std::placeholders::_1));
+  jsEngine->SetEventCallback("_startupPhase", std::bind(
+      &FilterEngine::StartupPhaseDone, this, std::placeholders::_1));
 
   {
     // Lock the JS engine while we are loading scripts, no timeouts should fire
@@ -156,12 +201,20 @@ FilterEngine::FilterEngine(JsEnginePtr jsEngine,
     jsEngine->SetGlobalProperty("_preconfiguredPrefs", preconfiguredPrefsObject);
     // Load adblockplus scripts
     for (int i = 0; !jsSources[i].empty(); i += 2)
+    {
+      const std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
       jsEngine->Evaluate(jsSources[i + 1], jsSources[i]);
+      startupReport.scriptEvaluation.push_back(
+          std::make_pair(jsSources[i], Utils::MicrosecondsSince(start)));
+    }
+    checkFilterMatchIdFunc = jsEngine->Evaluate("API.checkFilterMatchId");
   }
 
   // TODO: This should really be implemented via a conditional variable
-  while (!initialized)
+  while (!initialized.load(std::memory_order_acquire))
     ::Sleep(10);
+  startupReport.total = Utils::MicrosecondsSince(constructionStart);
 }
 
 namespace
@@ -213,8 +266,22 @@ FilterEngine::ContentType FilterEngine::StringToContentType(const std::string& c
 void FilterEngine::InitDone(JsValueList& params)
 {
   jsEngine->RemoveEventCallback("_init");
-  initialized = true;
+  jsEngine->RemoveEventCallback("_startupPhase");
+  startupReport.initialized = Utils::MicrosecondsSince(constructionStart);
   firstRun = params.size() && params[0]->AsBool();
+  initialized.store(true, std::memory_order_release);
+}
+
+void FilterEngine::StartupPhaseDone(JsValueList& params)
+{
+  const std::string phase = params.size() ? params[0]->AsString() : "";
+  const int64_t elapsed = Utils::MicrosecondsSince(constructionStart);
+  if (phase == "prefs")
+    startupReport.prefsLoaded = elapsed;
+  else if (phase == "filters")
+    startupReport.filtersLoaded = elapsed;
+  else if (phase == "matchers")
+    startupReport.matchersPopulated = elapsed;
 }
 
 bool FilterEngine::IsFirstRun() const
@@ -224,47 +291,79 @@ bool FilterEngine::IsFirstRun() const
 
 FilterPtr FilterEngine::GetFilter(const std::string& text)
 {
-  JsValuePtr func = jsEngine->Evaluate("API.getFilterFromText");
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getFilterIdFromText");
   JsValueList params;
   params.push_back(jsEngine->NewValue(text));
-  return FilterPtr(new Filter(std::move(*func->Call(params))));
+  return GetFilterWrapper(static_cast<int>(func->Call(params)->AsInt()));
 }
 
 SubscriptionPtr FilterEngine::GetSubscription(const std::string& url)
 {
-  JsValuePtr func = jsEngine->Evaluate("API.getSubscriptionFromUrl");
-  JsValueList params;
-  params.push_back(jsEngine->NewValue(url));
-  return SubscriptionPtr(new Subscription(std::move(*func->Call(params))));
+  const JsContext context(jsEngine);
+  return GetSubscriptionWrapper(url);
+}
+
+FilterEngineStatistics FilterEngine::GetStatistics() const
+{
+  FilterEngineStatistics result;
+  result.matches = matchesLatency.GetStatistics();
+  result.checkFilterMatch = checkFilterMatchLatency.GetStatistics();
+  result.getElementHidingSelectors = elementHidingSelectorsLatency.GetStatistics();
+  result.isDocumentWhitelisted = documentWhitelistedLatency.GetStatistics();
+  result.filterChangeCallback = filterChangeCallbackLatency.GetStatistics();
+  result.filterInfoCacheHits =
+      filterInfoCacheHits.load(std::memory_order_relaxed);
+  result.filterInfoCacheMisses =
+      filterInfoCacheMisses.load(std::memory_order_relaxed);
+  {
+    const JsContext context(jsEngine, false);
+    JsValuePtr func = jsEngine->Evaluate("API.getMatcherCacheStatistics");
+    const JsValueList cacheStatistics = func->Call()->AsList();
+    result.matcherCacheHits = cacheStatistics[0]->AsInt();
+    result.matcherCacheMisses = cacheStatistics[1]->AsInt();
+  }
+  result.jsEngine = jsEngine->GetStatistics();
+  return result;
 }
 
 std::vector<FilterPtr> FilterEngine::GetListedFilters() const
 {
-  JsValuePtr func = jsEngine->Evaluate("API.getListedFilters");
-  JsValueList values = func->Call()->AsList();
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getListedFilterIds");
+  std::vector<int64_t> ids = func->Call()->AsInt64Vector();
   std::vector<FilterPtr> result;
-  for (JsValueList::iterator it = values.begin(); it != values.end(); it++)
-	  result.push_back(FilterPtr(new Filter(std::move(**it))));
+  for (std::vector<int64_t>::iterator it = ids.begin(); it != ids.end(); it++)
+    result.push_back(GetFilterWrapper(static_cast<int>(*it)));
   return result;
 }
 
+int FilterEngine::GetFilterCount() const
+{
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getFilterCount");
+  return static_cast<int>(func->Call()->AsInt());
+}
+
 std::vector<SubscriptionPtr> FilterEngine::GetListedSubscriptions() const
 {
-  JsValuePtr func = jsEngine->Evaluate("API.getListedSubscriptions");
-  JsValueList values = func->Call()->AsList();
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getListedSubscriptionUrls");
+  std::vector<std::string> urls = func->Call()->AsStringVector();
   std::vector<SubscriptionPtr> result;
-  for (JsValueList::iterator it = values.begin(); it != values.end(); it++)
-	  result.push_back(SubscriptionPtr(new Subscription(std::move(**it))));
+  for (std::vector<std::string>::iterator it = urls.begin(); it != urls.end(); it++)
+    result.push_back(GetSubscriptionWrapper(*it));
   return result;
 }
 
 std::vector<SubscriptionPtr> FilterEngine::FetchAvailableSubscriptions() const
 {
-  JsValuePtr func = jsEngine->Evaluate("API.getRecommendedSubscriptions");
-  JsValueList values = func->Call()->AsList();
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getRecommendedSubscriptionUrls");
+  std::vector<std::string> urls = func->Call()->AsStringVector();
   std::vector<SubscriptionPtr> result;
-  for (JsValueList::iterator it = values.begin(); it != values.end(); it++)
-	  result.push_back(SubscriptionPtr(new Subscription(std::move(**it))));
+  for (std::vector<std::string>::iterator it = urls.begin(); it != urls.end(); it++)
+    result.push_back(GetSubscriptionWrapper(*it));
   return result;
 }
 
@@ -307,6 +406,16 @@ AdblockPlus::FilterPtr FilterEngine::Matches(const std::string& url,
     ContentType contentType,
     const std::vector<std::string>& documentUrls) const
 {
+  const LatencyHistogram::Scope timer(matchesLatency);
+  return MatchFilter(url, contentType, documentUrls);
+}
+
+AdblockPlus::FilterPtr FilterEngine::MatchFilter(const std::string& url,
+    ContentType contentType,
+    const std::vector<std::string>& documentUrls) const
+{
+  // Hold the engine lock for all lookups rather than per JsValue operation
+  const JsContext context(jsEngine);
   if (documentUrls.empty())
     return CheckFilterMatch(url, contentType, "");
 
@@ -325,9 +434,57 @@ AdblockPlus::FilterPtr FilterEngine::Matches(const std::string& url,
   return CheckFilterMatch(url, contentType, lastDocumentUrl);
 }
 
+bool FilterEngine::Matches(const std::string& url,
+    ContentType contentType,
+    const std::vector<std::string>& documentUrls,
+    MatchResult& result) const
+{
+  const LatencyHistogram::Scope timer(matchesLatency);
+  const JsContext context(jsEngine);
+  int id = 0;
+  if (documentUrls.empty())
+    id = CheckFilterMatchId(url, contentType, "");
+  else
+  {
+    std::string lastDocumentUrl = documentUrls.front();
+    for (std::vector<std::string>::const_iterator it = documentUrls.begin();
+         it != documentUrls.end(); it++)
+    {
+      const std::string& documentUrl = *it;
+      id = CheckFilterMatchId(documentUrl, CONTENT_TYPE_DOCUMENT,
+                              lastDocumentUrl);
+      if (id && GetFilterInfo(id).type == Filter::TYPE_EXCEPTION)
+        break;
+      id = 0;
+      lastDocumentUrl = documentUrl;
+    }
+    if (!id)
+      id = CheckFilterMatchId(url, contentType, lastDocumentUrl);
+  }
+
+  result.filterId = id;
+  if (!id)
+  {
+    result.decision = MatchResult::DECISION_NONE;
+    result.filterType = Filter::TYPE_INVALID;
+    result.collapse = false;
+    result.text = 0;
+    return false;
+  }
+
+  const FilterInfo& info = GetFilterInfo(id);
+  result.filterType = info.type;
+  result.decision = info.type == Filter::TYPE_EXCEPTION ?
+      MatchResult::DECISION_ALLOW : MatchResult::DECISION_BLOCK;
+  result.collapse = info.collapse;
+  result.text = &info.text;
+  return true;
+}
+
 bool FilterEngine::IsDocumentWhitelisted(const std::string& url,
     const std::vector<std::string>& documentUrls) const
 {
+    const LatencyHistogram::Scope timer(documentWhitelistedLatency);
     return !!GetWhitelistingFilter(url, CONTENT_TYPE_DOCUMENT, documentUrls);
 }
 
@@ -341,28 +498,141 @@ AdblockPlus::FilterPtr FilterEngine::CheckFilterMatch(const std::string& url,
     ContentType contentType,
     const std::string& documentUrl) const
 {
-  JsValuePtr func = jsEngine->Evaluate("API.checkFilterMatch");
+  const JsContext context(jsEngine);
+  const int id = CheckFilterMatchId(url, contentType, documentUrl);
+  return id ? GetFilterWrapper(id) : FilterPtr();
+}
+
+int FilterEngine::CheckFilterMatchId(const std::string& url,
+    ContentType contentType,
+    const std::string& documentUrl) const
+{
+  const LatencyHistogram::Scope timer(checkFilterMatchLatency);
   JsValueList params;
   params.push_back(jsEngine->NewValue(url));
   params.push_back(jsEngine->NewValue(ContentTypeToString(contentType)));
   params.push_back(jsEngine->NewValue(documentUrl));
+  return static_cast<int>(checkFilterMatchIdFunc->Call(params)->AsInt());
+}
+
+FilterPtr FilterEngine::GetFilterWrapper(int id) const
+{
+  // On a cache miss the filter object is only retrieved once, for both the
+  // cache entry and the wrapper.
+  JsValuePtr object;
+  GetFilterInfo(id, &object);
+  FilterInfo& info = filterInfo[id];
+  FilterPtr filter = info.wrapper.lock();
+  if (!filter)
+  {
+    if (!object)
+      object = GetFilterById(jsEngine, id);
+    filter.reset(new Filter(std::move(*object), info.type, info.text));
+    info.wrapper = filter;
+  }
+  return filter;
+}
+
+SubscriptionPtr FilterEngine::GetSubscriptionWrapper(const std::string& url) const
+{
+  SubscriptionWrapperMap::iterator it = subscriptionWrappers.find(url);
+  if (it != subscriptionWrappers.end())
+  {
+    SubscriptionPtr subscription = it->second.lock();
+    if (subscription)
+      return subscription;
+  }
+
+  JsValuePtr func = jsEngine->Evaluate("API.getSubscriptionFromUrl");
+  JsValueList params;
+  params.push_back(jsEngine->NewValue(url));
+  SubscriptionPtr subscription(new Subscription(std::move(*func->Call(params))));
+
+  // There are few subscriptions, dropping expired entries on every insertion
+  // is cheap enough.
+  for (it = subscriptionWrappers.begin(); it != subscriptionWrappers.end();)
+  {
+    if (it->second.expired())
+      subscriptionWrappers.erase(it++);
+    else
+      ++it;
+  }
+  subscriptionWrappers[url] = subscription;
+  return subscription;
+}
+
+const FilterEngine::FilterInfo& FilterEngine::GetFilterInfo(int id,
+    JsValuePtr* filterObject) const
+{
+  if (id > 0 && static_cast<size_t>(id) < filterInfo.size() &&
+      filterInfo[id].loaded)
+  {
+    filterInfoCacheHits.fetch_add(1, std::memory_order_relaxed);
+    return filterInfo[id];
+  }
+  filterInfoCacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+  JsValuePtr filter = GetFilterById(jsEngine, id);
+
+  if (static_cast<size_t>(id) >= filterInfo.size())
+    filterInfo.resize(id + 1);
+  FilterInfo& info = filterInfo[id];
+  info.type = ReadFilterType(*filter);
+  // A collapse value of null means "use the default", which is to collapse
+  JsValuePtr collapse = filter->GetProperty(collapseName);
+  info.collapse = info.type == Filter::TYPE_BLOCKING &&
+      !(collapse->IsBool() && !collapse->AsBool());
+  info.text = filter->GetProperty(textName)->AsString();
+  info.loaded = true;
+  if (filterObject)
+    *filterObject = filter;
+  return info;
+}
+
+const std::string& FilterEngine::GetFilterText(int id) const
+{
+  const JsContext context(jsEngine);
+  return GetFilterInfo(id).text;
+}
+
+Filter::Type FilterEngine::GetFilterType(int id) const
+{
+  const JsContext context(jsEngine);
+  return GetFilterInfo(id).type;
+}
+
+std::vector<std::string> FilterEngine::GetFilterSubscriptions(int id) const
+{
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getFilterSubscriptionsById");
+  JsValueList params;
+  params.push_back(jsEngine->NewValue(id));
   JsValuePtr result = func->Call(params);
-  if (!result->IsNull())
-	  return FilterPtr(new Filter(std::move(*result)));
-  else
-    return FilterPtr();
+  if (result->IsNull())
+    throw std::invalid_argument("Unknown filter ID");
+  return result->AsStringVector();
+}
+
+int FilterEngine::GetFilterHitCount(int id) const
+{
+  const JsContext context(jsEngine);
+  JsValuePtr func = jsEngine->Evaluate("API.getFilterHitCountById");
+  JsValueList params;
+  params.push_back(jsEngine->NewValue(id));
+  JsValuePtr result = func->Call(params);
+  if (result->IsNull())
+    throw std::invalid_argument("Unknown filter ID");
+  return static_cast<int>(result->AsInt());
 }
 
 std::vector<std::string> FilterEngine::GetElementHidingSelectors(const std::string& domain) const
 {
+  const LatencyHistogram::Scope timer(elementHidingSelectorsLatency);
+  const JsContext context(jsEngine);
   JsValuePtr func = jsEngine->Evaluate("API.getElementHidingSelectors");
   JsValueList params;
   params.push_back(jsEngine->NewValue(domain));
-  JsValueList result = func->Call(params)->AsList();
-  std::vector<std::string> selectors;
-  for (JsValueList::iterator it = result.begin(); it != result.end(); ++it)
-    selectors.push_back((*it)->AsString());
-  return selectors;
+  return func->Call(params)->AsStringVector();
 }
 
 JsValuePtr FilterEngine::GetPref(const std::string& pref) const
@@ -447,6 +717,7 @@ void FilterEngine::RemoveFilterChangeCallback()
 
 void FilterEngine::FilterChanged(FilterEngine::FilterChangeCallback callback, JsValueList& params)
 {
+  const LatencyHistogram::Scope timer(filterChangeCallbackLatency);
   std::string action(params.size() >= 1 && !params[0]->IsNull() ? params[0]->AsString() : "");
   JsValuePtr item(params.size() >= 2 ? params[1] : jsEngine->NewValue(false));
   callback(action, item);
@@ -478,7 +749,8 @@ int FilterEngine::CompareVersions(const std::string& v1, const std::string& v2)
 FilterPtr FilterEngine::GetWhitelistingFilter(const std::string& url,
   ContentType contentType, const std::string& documentUrl) const
 {
-  FilterPtr match = Matches(url, contentType, documentUrl);
+  FilterPtr match = MatchFilter(url, contentType,
+      std::vector<std::string>(1, documentUrl));
   if (match && match->GetType() == Filter::TYPE_EXCEPTION)
   {
     return match;
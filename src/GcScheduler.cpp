@@ -0,0 +1,91 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <AdblockPlus/JsEngine.h>
+
+#include "GcScheduler.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  // Upper bound for the slices per idle period, in case V8 never reports
+  // being done.
+  const int maxSlices = 1000;
+}
+
+GcScheduler::GcScheduler(JsEngine& jsEngine, int idleTimeMs, int sliceTimeMs)
+  : jsEngine(jsEngine), idleTime(idleTimeMs), sliceTime(sliceTimeMs),
+    stopped(false)
+{
+  Start();
+}
+
+GcScheduler::~GcScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  wakeUp.notify_one();
+  Join();
+}
+
+void GcScheduler::Run()
+{
+  uint32_t lastActivityCount = GetActivityCount();
+  // Nothing to collect before the engine is used
+  bool collected = true;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopped)
+  {
+    wakeUp.wait_for(lock, std::chrono::milliseconds(idleTime));
+    if (stopped)
+      break;
+
+    const uint32_t activityCount = GetActivityCount();
+    if (activityCount != lastActivityCount)
+    {
+      lastActivityCount = activityCount;
+      collected = false;
+    }
+    else if (!collected)
+    {
+      lock.unlock();
+      collected = CollectWhileIdle(activityCount);
+      lock.lock();
+    }
+  }
+}
+
+uint32_t GcScheduler::GetActivityCount() const
+{
+  return jsEngine.activityCount.load(std::memory_order_relaxed);
+}
+
+bool GcScheduler::CollectWhileIdle(uint32_t activityCount)
+{
+  for (int i = 0; i < maxSlices; i++)
+  {
+    if (stopped || GetActivityCount() != activityCount)
+      return false;
+    if (jsEngine.CollectGarbageSlice(sliceTime))
+      return true;
+  }
+  return true;
+}
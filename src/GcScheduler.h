@@ -0,0 +1,66 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_GC_SCHEDULER_H
+#define ADBLOCK_PLUS_GC_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+
+#include "Thread.h"
+
+namespace AdblockPlus
+{
+  class JsEngine;
+
+  /**
+   * Collects garbage on a background thread once the engine hasn't been used
+   * for a while, see JsEngine::EnableIdleGc(). Garbage is collected in short
+   * slices, releasing the engine lock in between, and collection stops as
+   * soon as the engine is used again.
+   */
+  class GcScheduler : public Thread
+  {
+  public:
+    GcScheduler(JsEngine& jsEngine, int idleTimeMs, int sliceTimeMs);
+
+    /**
+     * Stops the thread and waits for it to finish.
+     */
+    ~GcScheduler();
+
+    void Run();
+
+  private:
+    GcScheduler(const GcScheduler&);
+    GcScheduler& operator=(const GcScheduler&);
+
+    uint32_t GetActivityCount() const;
+    bool CollectWhileIdle(uint32_t activityCount);
+
+    JsEngine& jsEngine;
+    const int idleTime;
+    const int sliceTime;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::atomic<bool> stopped;
+  };
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "GlobalJsObject.h"
 #include "ConsoleJsObject.h"
 #include "WebRequestJsObject.h"
+#include "PendingTask.h"
 #include "Thread.h"
 #include "Utils.h"
 
@@ -36,7 +37,8 @@ namespace
   class TimeoutThread : public Thread
   {
   public:
-    TimeoutThread(JsValueList& arguments)
+    TimeoutThread(JsEnginePtr jsEngine, JsValueList& arguments)
+      : pendingTask(jsEngine, PendingTask::TYPE_TIMER)
     {
       if (arguments.size() < 2)
         throw std::runtime_error("setTimeout requires at least 2 parameters");
@@ -56,9 +58,11 @@ namespace
       Sleep(delay);
 
       function->Call(functionArguments);
+      delete this;
     }
 
   private:
+    PendingTask pendingTask;
     JsValuePtr function;
     int delay;
     JsValueList functionArguments;
@@ -69,10 +73,11 @@ namespace
     TimeoutThread* timeoutThread;
     try
     {
+      AdblockPlus::JsEnginePtr jsEngine =
+          AdblockPlus::JsEngine::FromArguments(arguments);
       AdblockPlus::JsValueList converted =
-          AdblockPlus::JsEngine::FromArguments(arguments)
-          ->ConvertArguments(arguments);
-      timeoutThread = new TimeoutThread(converted);
+          jsEngine->ConvertArguments(arguments);
+      timeoutThread = new TimeoutThread(jsEngine, converted);
     }
     catch (const std::exception& e)
     {
@@ -17,9 +17,75 @@
 
 #include "JsContext.h"
 
-AdblockPlus::JsContext::JsContext(const JsEnginePtr jsEngine)
-: locker(jsEngine->GetIsolate()), isolateScope(jsEngine->GetIsolate()),
-handleScope(jsEngine->GetIsolate()),
-contextScope(v8::Local<v8::Context>::New(jsEngine->GetIsolate(), *jsEngine->context))
+namespace
 {
+  // Isolate data slot holding the engine whose context the thread holding
+  // the isolate's lock entered last.
+  const uint32_t enteredEngineDataSlot = 0;
+
+  bool IsEntered(AdblockPlus::JsEngine& jsEngine)
+  {
+    v8::Isolate* isolate = jsEngine.GetIsolate();
+    return v8::Locker::IsLocked(isolate) &&
+        isolate->GetData(enteredEngineDataSlot) == &jsEngine;
+  }
+}
+
+AdblockPlus::JsContext::Lock::Lock(v8::Isolate* isolate)
+  : locker(isolate), isolateScope(isolate)
+{
+}
+
+AdblockPlus::JsContext::JsContext(const JsEnginePtr& jsEngine, bool isActivity)
+: jsEngine(jsEngine), nested(IsEntered(*jsEngine)), isActivity(isActivity),
+  previousEngine(0)
+{
+  v8::Isolate* isolate = jsEngine->GetIsolate();
+  if (nested)
+  {
+    // Handles created in nested code are still released early
+    ::new (&handleScope) v8::HandleScope(isolate);
+    return;
+  }
+
+  const std::chrono::steady_clock::time_point lockRequested =
+      std::chrono::steady_clock::now();
+  ::new (&lock) Lock(isolate);
+  ::new (&handleScope) v8::HandleScope(isolate);
+  ::new (&contextScope) v8::Context::Scope(
+      v8::Local<v8::Context>::New(isolate, *jsEngine->context));
+  previousEngine = isolate->GetData(enteredEngineDataSlot);
+  isolate->SetData(enteredEngineDataSlot, jsEngine.get());
+  if (!isActivity)
+    return;
+
+  // Not an atomic increment, the engine is locked now
+  std::atomic<uint32_t>& activityCount = jsEngine->activityCount;
+  activityCount.store(activityCount.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+  lockAcquired = std::chrono::steady_clock::now();
+  jsEngine->lockCount++;
+  jsEngine->lockWaitTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      lockAcquired - lockRequested).count();
+  jsEngine->lockDepth++;
+}
+
+AdblockPlus::JsContext::~JsContext()
+{
+  if (!nested)
+  {
+    // The engine can be entered again while another engine sharing the
+    // isolate is entered, the hold time only counts once the outermost
+    // context releases the lock.
+    if (isActivity && --jsEngine->lockDepth == 0)
+    {
+      jsEngine->lockHoldTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - lockAcquired).count();
+    }
+    jsEngine->GetIsolate()->SetData(enteredEngineDataSlot, previousEngine);
+    reinterpret_cast<v8::Context::Scope*>(&contextScope)->~Scope();
+  }
+  reinterpret_cast<v8::HandleScope*>(&handleScope)->~HandleScope();
+  if (!nested)
+    reinterpret_cast<Lock*>(&lock)->~Lock();
 }
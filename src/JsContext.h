@@ -18,22 +18,58 @@
 #ifndef ADBLOCK_PLUS_JS_CONTEXT_H
 #define ADBLOCK_PLUS_JS_CONTEXT_H
 
+#include <chrono>
+#include <type_traits>
 #include <v8.h>
 #include <AdblockPlus/JsEngine.h>
 
 namespace AdblockPlus
 {
+  /**
+   * Locks the engine and enters its context. Nested instances on a thread
+   * that already entered the engine (e.g. within a JsEngine::Scope or in a
+   * callback from JavaScript) only open a handle scope. They neither lock
+   * nor enter the context again and aren't counted in the lock statistics.
+   */
   class JsContext
   {
   public:
-    JsContext(const JsEnginePtr jsEngine);
-    virtual ~JsContext() {};
+    /**
+     * @param jsEngine Engine to lock.
+     * @param isActivity `false` for bookkeeping like reading statistics,
+     *        which neither delays idle garbage collection nor shows up in
+     *        the lock statistics.
+     */
+    explicit JsContext(const JsEnginePtr& jsEngine, bool isActivity = true);
+    virtual ~JsContext();
 
   private:
-    const v8::Locker locker;
-    const v8::Isolate::Scope isolateScope;
-    const v8::HandleScope handleScope;
-    const v8::Context::Scope contextScope;
+    struct Lock
+    {
+      explicit Lock(v8::Isolate* isolate);
+
+      const v8::Locker locker;
+      const v8::Isolate::Scope isolateScope;
+    };
+
+    JsContext(const JsContext&);
+    JsContext& operator=(const JsContext&);
+
+    // Keeps the engine alive until the storage below has been torn down,
+    // a JsEngine::Scope can outlive its caller's references.
+    const JsEnginePtr jsEngine;
+    const bool nested;
+    const bool isActivity;
+    std::chrono::steady_clock::time_point lockAcquired;
+    void* previousEngine;
+    // Constructed in place so that nested instances can skip the lock and
+    // the context scope, destroyed in reverse order by the destructor.
+    std::aligned_storage<sizeof(Lock),
+        std::alignment_of<Lock>::value>::type lock;
+    std::aligned_storage<sizeof(v8::HandleScope),
+        std::alignment_of<v8::HandleScope>::value>::type handleScope;
+    std::aligned_storage<sizeof(v8::Context::Scope),
+        std::alignment_of<v8::Context::Scope>::value>::type contextScope;
   };
 }
 
@@ -15,7 +15,11 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <AdblockPlus.h>
+#include "GcScheduler.h"
 #include "GlobalJsObject.h"
 #include "JsContext.h"
 #include "JsError.h"
@@ -38,6 +42,23 @@ namespace
       return v8::Script::Compile(v8Source);
   }
 
+  // Embedder data slot of the engine's context holding the JsEngine pointer.
+  // Slot 0 is reserved for the debugger.
+  const int engineEmbedderDataIndex = 1;
+
+  v8::Isolate::CreateParams CreateIsolateParams(
+      const AdblockPlus::ResourceConstraints& constraints)
+  {
+    v8::Isolate::CreateParams params;
+    if (constraints.maxSemiSpaceSize)
+      params.constraints.set_max_semi_space_size(constraints.maxSemiSpaceSize);
+    if (constraints.maxOldSpaceSize)
+      params.constraints.set_max_old_space_size(constraints.maxOldSpaceSize);
+    if (constraints.maxExecutableSize)
+      params.constraints.set_max_executable_size(constraints.maxExecutableSize);
+    return params;
+  }
+
   void CheckTryCatch(const v8::TryCatch& tryCatch)
   {
     if (tryCatch.HasCaught())
@@ -71,8 +92,9 @@ namespace
   };
 }
 
-AdblockPlus::ScopedV8Isolate::ScopedV8Isolate()
-: isolate(v8::Isolate::New())
+AdblockPlus::ScopedV8Isolate::ScopedV8Isolate(
+    const ResourceConstraints& constraints)
+: isolate(v8::Isolate::New(CreateIsolateParams(constraints)))
 {
 }
 
@@ -82,26 +104,80 @@ AdblockPlus::ScopedV8Isolate::~ScopedV8Isolate()
 	isolate = nullptr;
 }
 
+AdblockPlus::JsEngine::Scope::Scope(const JsEnginePtr& jsEngine)
+  : context(new JsContext(jsEngine))
+{
+}
+
+AdblockPlus::JsEngine::Scope::~Scope()
+{
+}
+
 AdblockPlus::JsEngine::JsEngine(const ScopedV8IsolatePtr& isolate)
-: isolate(isolate ? isolate : std::make_shared<ScopedV8Isolate>())
+: isolate(isolate ? isolate : std::make_shared<ScopedV8Isolate>()),
+  liveValues(0), pendingTimers(0), pendingIoThreads(0), activityCount(0),
+  lockCount(0), lockWaitTime(0), lockHoldTime(0), lockDepth(0),
+  startupReport()
 {
 }
 
+AdblockPlus::JsEngine::~JsEngine()
+{
+  // The scheduler thread uses the engine, stop it before anything else
+  gcScheduler.reset();
+
+  // Callbacks still running in the context mustn't find the engine anymore
+  if (context)
+  {
+    const v8::Locker locker(GetIsolate());
+    const v8::Isolate::Scope isolateScope(GetIsolate());
+    const v8::HandleScope handleScope(GetIsolate());
+    v8::Local<v8::Context>::New(GetIsolate(), *context)
+        ->SetAlignedPointerInEmbedderData(engineEmbedderDataIndex, 0);
+  }
+}
+
 AdblockPlus::JsEnginePtr AdblockPlus::JsEngine::New(const AppInfo& appInfo, const ScopedV8IsolatePtr& isolate)
 {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
   V8Initializer::Init();
+  const int64_t v8Initialization = Utils::MicrosecondsSince(start);
+
+  start = std::chrono::steady_clock::now();
   JsEnginePtr result(new JsEngine(isolate));
+  result->startupReport.v8Initialization = v8Initialization;
+  result->startupReport.isolateCreation =
+      isolate ? 0 : Utils::MicrosecondsSince(start);
 
   const v8::Locker locker(result->GetIsolate());
   const v8::Isolate::Scope isolateScope(result->GetIsolate());
   const v8::HandleScope handleScope(result->GetIsolate());
 
+  start = std::chrono::steady_clock::now();
   result->context.reset(new v8::UniquePersistent<v8::Context>(result->GetIsolate(), v8::Context::New(result->GetIsolate())));
+  // The context never outlives the engine, so a plain pointer is sufficient.
+  v8::Local<v8::Context>::New(result->GetIsolate(), *result->context)
+      ->SetAlignedPointerInEmbedderData(engineEmbedderDataIndex, result.get());
+  result->startupReport.contextCreation = Utils::MicrosecondsSince(start);
 
+  start = std::chrono::steady_clock::now();
   v8::Local<v8::Object> globalContext = v8::Local<v8::Context>::New(result->GetIsolate(), *result->context)->Global();
-  result->globalJsObject = JsValuePtr(new JsValue(result, globalContext));
+  result->globalJsObject = JsValue::Create(result, globalContext);
 
   AdblockPlus::GlobalJsObject::Setup(result, appInfo, result->globalJsObject);
+  result->startupReport.globalSetup = Utils::MicrosecondsSince(start);
+  return result;
+}
+
+AdblockPlus::JsEnginePtr AdblockPlus::JsEngine::New(const AppInfo& appInfo,
+    const ResourceConstraints& constraints)
+{
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  ScopedV8IsolatePtr isolate = std::make_shared<ScopedV8Isolate>(constraints);
+  const int64_t isolateCreation = Utils::MicrosecondsSince(start);
+  JsEnginePtr result = New(appInfo, isolate);
+  result->startupReport.isolateCreation = isolateCreation;
   return result;
 }
 
@@ -115,7 +191,7 @@ AdblockPlus::JsValuePtr AdblockPlus::JsEngine::Evaluate(const std::string& sourc
   CheckTryCatch(tryCatch);
   v8::Local<v8::Value> result = script->Run();
   CheckTryCatch(tryCatch);
-  return JsValuePtr(new JsValue(shared_from_this(), result));
+  return JsValue::Create(shared_from_this(), result);
 }
 
 void AdblockPlus::JsEngine::SetEventCallback(const std::string& eventName,
@@ -138,33 +214,96 @@ void AdblockPlus::JsEngine::TriggerEvent(const std::string& eventName, AdblockPl
 
 void AdblockPlus::JsEngine::Gc()
 {
-	while (!GetIsolate()->IdleNotification(1000));
+  while (!CollectGarbageSlice(1000));
+}
+
+void AdblockPlus::JsEngine::EnableIdleGc(int idleTimeMs, int sliceTimeMs)
+{
+  gcScheduler.reset();
+  gcScheduler.reset(new GcScheduler(*this, idleTimeMs, sliceTimeMs));
+}
+
+void AdblockPlus::JsEngine::DisableIdleGc()
+{
+  gcScheduler.reset();
+}
+
+bool AdblockPlus::JsEngine::CollectGarbageSlice(int idleTimeMs)
+{
+  const v8::Locker locker(GetIsolate());
+  const v8::Isolate::Scope isolateScope(GetIsolate());
+  const LatencyHistogram::Scope timer(gcPauses);
+  return GetIsolate()->IdleNotification(idleTimeMs);
+}
+
+AdblockPlus::JsEngineStatistics AdblockPlus::JsEngine::GetStatistics()
+{
+  JsEngineStatistics result;
+  {
+    // Polling statistics mustn't keep the engine from being idle
+    const JsContext context(shared_from_this(), false);
+    v8::HeapStatistics heapStatistics;
+    GetIsolate()->GetHeapStatistics(&heapStatistics);
+    result.totalHeapSize = heapStatistics.total_heap_size();
+    result.totalHeapSizeExecutable = heapStatistics.total_heap_size_executable();
+    result.totalPhysicalSize = heapStatistics.total_physical_size();
+    result.usedHeapSize = heapStatistics.used_heap_size();
+    result.heapSizeLimit = heapStatistics.heap_size_limit();
+    result.lockCount = lockCount;
+    result.lockWaitTime = lockWaitTime / 1000;
+    result.lockHoldTime = lockHoldTime / 1000;
+  }
+  result.gcPauses = gcPauses.GetStatistics();
+  result.liveValues = liveValues;
+  result.pendingTimers = pendingTimers;
+  result.pendingIoThreads = pendingIoThreads;
+  return result;
+}
+
+void AdblockPlus::JsEngine::NotifyMemoryPressure(MemoryPressureLevel level)
+{
+  const JsContext context(shared_from_this());
+
+  // Scripts drop their caches first, so that V8 can reclaim them right away
+  JsValuePtr handler = globalJsObject->GetProperty("_onMemoryPressure");
+  if (handler->IsFunction())
+  {
+    JsValueList params;
+    params.push_back(NewValue(
+        level == MEMORY_PRESSURE_CRITICAL ? "critical" : "moderate"));
+    handler->Call(params);
+  }
+
+  if (level == MEMORY_PRESSURE_CRITICAL)
+    GetIsolate()->LowMemoryNotification();
+  else
+    GetIsolate()->IdleNotification(100);
 }
 
 AdblockPlus::JsValuePtr AdblockPlus::JsEngine::NewValue(const std::string& val)
 {
   const JsContext context(shared_from_this());
-  return JsValuePtr(new JsValue(shared_from_this(),
-	  Utils::ToV8String(GetIsolate(), val)));
+  return JsValue::Create(shared_from_this(),
+	  Utils::ToV8String(GetIsolate(), val));
 }
 
 AdblockPlus::JsValuePtr AdblockPlus::JsEngine::NewValue(int64_t val)
 {
   const JsContext context(shared_from_this());
-  return JsValuePtr(new JsValue(shared_from_this(),
-	  v8::Number::New(GetIsolate(), val)));
+  return JsValue::Create(shared_from_this(),
+	  v8::Number::New(GetIsolate(), val));
 }
 
 AdblockPlus::JsValuePtr AdblockPlus::JsEngine::NewValue(bool val)
 {
   const JsContext context(shared_from_this());
-  return JsValuePtr(new JsValue(shared_from_this(), v8::Boolean::New(GetIsolate(), val)));
+  return JsValue::Create(shared_from_this(), v8::Boolean::New(GetIsolate(), val));
 }
 
 AdblockPlus::JsValuePtr AdblockPlus::JsEngine::NewObject()
 {
   const JsContext context(shared_from_this());
-  return JsValuePtr(new JsValue(shared_from_this(), v8::Object::New(GetIsolate())));
+  return JsValue::Create(shared_from_this(), v8::Object::New(GetIsolate()));
 }
 
 AdblockPlus::JsValuePtr AdblockPlus::JsEngine::NewCallback(
@@ -172,26 +311,36 @@ AdblockPlus::JsValuePtr AdblockPlus::JsEngine::NewCallback(
 {
   const JsContext context(shared_from_this());
 
-  // Note: we are leaking this weak pointer, no obvious way to destroy it when
-  // it's no longer used
-  std::weak_ptr<JsEngine>* data =
-      new std::weak_ptr<JsEngine>(shared_from_this());
-  v8::Local<v8::FunctionTemplate> templ = v8::FunctionTemplate::New(GetIsolate()
-	  , callback,
-	  v8::External::New(GetIsolate(), data));
-  return JsValuePtr(new JsValue(shared_from_this(), templ->GetFunction()));
+  std::unique_ptr<v8::UniquePersistent<v8::FunctionTemplate>>& templ =
+      callbackTemplates[callback];
+  if (!templ)
+  {
+    templ.reset(new v8::UniquePersistent<v8::FunctionTemplate>(GetIsolate(),
+        v8::FunctionTemplate::New(GetIsolate(), callback)));
+  }
+  return JsValue::Create(shared_from_this(),
+      v8::Local<v8::FunctionTemplate>::New(GetIsolate(), *templ)->GetFunction());
 }
 
 AdblockPlus::JsEnginePtr AdblockPlus::JsEngine::FromArguments(const v8::FunctionCallbackInfo<v8::Value>& arguments)
 {
-  const v8::Local<const v8::External> external =
-      v8::Local<const v8::External>::Cast(arguments.Data());
-  std::weak_ptr<JsEngine>* data =
-      static_cast<std::weak_ptr<JsEngine>*>(external->Value());
-  JsEnginePtr result = data->lock();
+  const v8::Local<v8::Context> context =
+      arguments.GetIsolate()->GetCurrentContext();
+  JsEngine* result = static_cast<JsEngine*>(
+      context->GetAlignedPointerFromEmbedderData(engineEmbedderDataIndex));
+  const char* const engineGone =
+      "Oops, our JsEngine is gone, how did that happen?";
   if (!result)
-    throw std::runtime_error("Oops, our JsEngine is gone, how did that happen?");
-  return result;
+    throw std::runtime_error(engineGone);
+  try
+  {
+    return result->shared_from_this();
+  }
+  catch (const std::bad_weak_ptr&)
+  {
+    // The engine is being destroyed
+    throw std::runtime_error(engineGone);
+  }
 }
 
 AdblockPlus::JsValueList AdblockPlus::JsEngine::ConvertArguments(const v8::FunctionCallbackInfo<v8::Value>& arguments)
@@ -199,7 +348,7 @@ AdblockPlus::JsValueList AdblockPlus::JsEngine::ConvertArguments(const v8::Funct
   const JsContext context(shared_from_this());
   JsValueList list;
   for (int i = 0; i < arguments.Length(); i++)
-    list.push_back(JsValuePtr(new JsValue(shared_from_this(), arguments[i])));
+    list.push_back(JsValue::Create(shared_from_this(), arguments[i]));
   return list;
 }
 
@@ -249,6 +398,23 @@ void AdblockPlus::JsEngine::SetLogSystem(AdblockPlus::LogSystemPtr val)
 }
 
 
+v8::Local<v8::String> AdblockPlus::JsEngine::GetPropertyName(const PropertyName& name)
+{
+  // The cache is only safe to access with the engine locked
+  assert(v8::Locker::IsLocked(GetIsolate()));
+  const size_t index = name.GetIndex();
+  if (index >= propertyNames.size())
+    propertyNames.resize(index + 1);
+  if (!propertyNames[index])
+  {
+    const std::string& str = name.GetName();
+    propertyNames[index].reset(new v8::UniquePersistent<v8::String>(GetIsolate(),
+        v8::String::NewFromUtf8(GetIsolate(), str.c_str(),
+            v8::String::kInternalizedString, str.length())));
+  }
+  return v8::Local<v8::String>::New(GetIsolate(), *propertyNames[index]);
+}
+
 void AdblockPlus::JsEngine::SetGlobalProperty(const std::string& name, 
                                               AdblockPlus::JsValuePtr value)
 {
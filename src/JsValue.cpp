@@ -15,28 +15,79 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
 #include <vector>
 #include <AdblockPlus.h>
 
 #include "JsContext.h"
 #include "JsError.h"
+#include "MemoryPool.h"
 #include "Utils.h"
 
+namespace
+{
+  std::vector<std::string> ToStringVector(v8::Local<v8::Array> array)
+  {
+    const uint32_t length = array->Length();
+    std::vector<std::string> result;
+    result.reserve(length);
+    for (uint32_t i = 0; i < length; i++)
+    {
+      result.push_back(std::string());
+      AdblockPlus::Utils::AppendV8String(result.back(), array->Get(i));
+    }
+    return result;
+  }
+
+  // The pools are shared by all engines and never destroyed, JsValue
+  // instances can outlive their engine and even static destructors.
+  // Blocks in valuePool hold a JsValue along with the shared_ptr control
+  // block allocated by JsValue::Create().
+  AdblockPlus::MemoryPool& valuePool = *new AdblockPlus::MemoryPool(128);
+  AdblockPlus::MemoryPool& handlePool = *new AdblockPlus::MemoryPool(
+      sizeof(v8::UniquePersistent<v8::Value>));
+
+  // Constant initialized, so static PropertyName instances can safely be
+  // registered from other translation units.
+  std::atomic<size_t> nextPropertyNameIndex(0);
+}
+
+AdblockPlus::PropertyName::PropertyName(const std::string& name)
+  : name(name), index(nextPropertyNameIndex++)
+{
+}
+
 AdblockPlus::JsValue::JsValue(AdblockPlus::JsEnginePtr jsEngine,
       v8::Handle<v8::Value> value)
     : jsEngine(jsEngine),
-	value(new v8::UniquePersistent<v8::Value>(jsEngine->GetIsolate(), value))
+	value(new(handlePool.Allocate())
+          v8::UniquePersistent<v8::Value>(jsEngine->GetIsolate(), value))
 {
+  jsEngine->liveValues.fetch_add(1, std::memory_order_relaxed);
 }
 
 AdblockPlus::JsValue::JsValue(AdblockPlus::JsValue&& src)
 : jsEngine(src.jsEngine),
-value(std::move(src.value))
+value(src.value)
 {
+  src.value = 0;
 }
 
 AdblockPlus::JsValue::~JsValue()
 {
+  if (value)
+  {
+    value->~UniquePersistent();
+    handlePool.Free(value);
+    jsEngine->liveValues.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+AdblockPlus::JsValuePtr AdblockPlus::JsValue::Create(
+    const JsEnginePtr& jsEngine, v8::Handle<v8::Value> value)
+{
+  return std::allocate_shared<JsValue>(
+      PoolAllocator<JsValue>(valuePool), jsEngine, value);
 }
 
 bool AdblockPlus::JsValue::IsUndefined() const
@@ -120,56 +171,119 @@ AdblockPlus::JsValueList AdblockPlus::JsValue::AsList() const
   for (uint32_t i = 0; i < length; i++)
   {
     v8::Local<v8::Value> item = array->Get(i);
-    result.push_back(JsValuePtr(new JsValue(jsEngine, item)));
+    result.push_back(JsValue::Create(jsEngine, item));
   }
   return result;
 }
 
-std::vector<std::string> AdblockPlus::JsValue::GetOwnPropertyNames() const
+std::vector<std::string> AdblockPlus::JsValue::AsStringVector() const
+{
+  if (!IsArray())
+    throw std::runtime_error("Cannot convert a non-array to list");
+
+  const JsContext context(jsEngine);
+  return ToStringVector(v8::Local<v8::Array>::Cast(UnwrapValue()));
+}
+
+std::vector<int64_t> AdblockPlus::JsValue::AsInt64Vector() const
+{
+  if (!IsArray())
+    throw std::runtime_error("Cannot convert a non-array to list");
+
+  const JsContext context(jsEngine);
+  v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(UnwrapValue());
+  const uint32_t length = array->Length();
+  std::vector<int64_t> result;
+  result.reserve(length);
+  for (uint32_t i = 0; i < length; i++)
+    result.push_back(array->Get(i)->IntegerValue());
+  return result;
+}
+
+std::map<std::string, std::string> AdblockPlus::JsValue::AsStringMap() const
 {
   if (!IsObject())
-    throw new std::runtime_error("Attempting to get propert list for a non-object");
+    throw std::runtime_error("Cannot convert a non-object to map");
 
   const JsContext context(jsEngine);
   v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(UnwrapValue());
-  JsValueList properties = JsValuePtr(new JsValue(jsEngine, object->GetOwnPropertyNames()))->AsList();
-  std::vector<std::string> result;
-  for (JsValueList::iterator it = properties.begin(); it != properties.end(); ++it)
-    result.push_back((*it)->AsString());
+  v8::Local<v8::Array> names = object->GetOwnPropertyNames();
+  const uint32_t length = names->Length();
+  std::map<std::string, std::string> result;
+  for (uint32_t i = 0; i < length; i++)
+  {
+    v8::Local<v8::Value> name = names->Get(i);
+    result[Utils::FromV8String(name)] = Utils::FromV8String(object->Get(name));
+  }
   return result;
 }
 
+std::vector<std::string> AdblockPlus::JsValue::GetOwnPropertyNames() const
+{
+  if (!IsObject())
+    throw std::runtime_error("Attempting to get propert list for a non-object");
+
+  const JsContext context(jsEngine);
+  v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(UnwrapValue());
+  return ToStringVector(object->GetOwnPropertyNames());
+}
+
 
 AdblockPlus::JsValuePtr AdblockPlus::JsValue::GetProperty(const std::string& name) const
+{
+  const JsContext context(jsEngine);
+  return GetProperty(Utils::ToV8String(jsEngine->GetIsolate(), name));
+}
+
+AdblockPlus::JsValuePtr AdblockPlus::JsValue::GetProperty(const PropertyName& name) const
+{
+  const JsContext context(jsEngine);
+  return GetProperty(jsEngine->GetPropertyName(name));
+}
+
+AdblockPlus::JsValuePtr AdblockPlus::JsValue::GetProperty(v8::Handle<v8::String> name) const
 {
   if (!IsObject())
     throw new std::runtime_error("Attempting to get property of a non-object");
 
-  const JsContext context(jsEngine);
-  v8::Local<v8::String> property = Utils::ToV8String(jsEngine->GetIsolate(), name);
   v8::Local<v8::Object> obj = v8::Local<v8::Object>::Cast(UnwrapValue());
-  return JsValuePtr(new JsValue(jsEngine, obj->Get(property)));
+  return JsValue::Create(jsEngine, obj->Get(name));
+}
+
+v8::Local<v8::Value> AdblockPlus::JsValue::UnwrapValue() const
+{
+  return v8::Local<v8::Value>::New(jsEngine->GetIsolate(), *value);
 }
 
 void AdblockPlus::JsValue::SetProperty(const std::string& name, v8::Handle<v8::Value> val)
+{
+  SetProperty(Utils::ToV8String(jsEngine->GetIsolate(), name), val);
+}
+
+void AdblockPlus::JsValue::SetProperty(const PropertyName& name, v8::Handle<v8::Value> val)
+{
+  SetProperty(jsEngine->GetPropertyName(name), val);
+}
+
+void AdblockPlus::JsValue::SetProperty(v8::Handle<v8::String> name, v8::Handle<v8::Value> val)
 {
   if (!IsObject())
     throw new std::runtime_error("Attempting to set property on a non-object");
 
-  v8::Local<v8::String> property = Utils::ToV8String(jsEngine->GetIsolate(), name);
   v8::Local<v8::Object> obj = v8::Local<v8::Object>::Cast(UnwrapValue());
-  obj->Set(property, val);
+  obj->Set(name, val);
 }
 
-v8::Local<v8::Value> AdblockPlus::JsValue::UnwrapValue() const
+void AdblockPlus::JsValue::SetProperty(const std::string& name, const std::string& val)
 {
-	return v8::Local<v8::Value>::New(jsEngine->GetIsolate(), *value);
+  const JsContext context(jsEngine);
+  SetProperty(name, Utils::ToV8String(jsEngine->GetIsolate(), val));
 }
 
-void AdblockPlus::JsValue::SetProperty(const std::string& name, const std::string& val)
+void AdblockPlus::JsValue::SetProperty(const std::string& name, std::string&& val)
 {
   const JsContext context(jsEngine);
-  SetProperty(name, Utils::ToV8String(jsEngine->GetIsolate(), val));
+  SetProperty(name, Utils::ToV8String(jsEngine->GetIsolate(), std::move(val)));
 }
 
 void AdblockPlus::JsValue::SetProperty(const std::string& name, int64_t val)
@@ -190,6 +304,36 @@ void AdblockPlus::JsValue::SetProperty(const std::string& name, bool val)
   SetProperty(name, v8::Boolean::New(jsEngine->GetIsolate(), val));
 }
 
+void AdblockPlus::JsValue::SetProperty(const PropertyName& name, const std::string& val)
+{
+  const JsContext context(jsEngine);
+  SetProperty(name, Utils::ToV8String(jsEngine->GetIsolate(), val));
+}
+
+void AdblockPlus::JsValue::SetProperty(const PropertyName& name, std::string&& val)
+{
+  const JsContext context(jsEngine);
+  SetProperty(name, Utils::ToV8String(jsEngine->GetIsolate(), std::move(val)));
+}
+
+void AdblockPlus::JsValue::SetProperty(const PropertyName& name, int64_t val)
+{
+  const JsContext context(jsEngine);
+  SetProperty(name, v8::Number::New(jsEngine->GetIsolate(), val));
+}
+
+void AdblockPlus::JsValue::SetProperty(const PropertyName& name, const JsValuePtr& val)
+{
+  const JsContext context(jsEngine);
+  SetProperty(name, val->UnwrapValue());
+}
+
+void AdblockPlus::JsValue::SetProperty(const PropertyName& name, bool val)
+{
+  const JsContext context(jsEngine);
+  SetProperty(name, v8::Boolean::New(jsEngine->GetIsolate(), val));
+}
+
 std::string AdblockPlus::JsValue::GetClass() const
 {
   if (!IsObject())
@@ -209,7 +353,7 @@ AdblockPlus::JsValuePtr AdblockPlus::JsValue::Call(const JsValueList& params, Js
   if (!thisPtr)
   {
 	  v8::Local<v8::Context> localContext = v8::Local<v8::Context>::New(jsEngine->GetIsolate(), *jsEngine->context);
-    thisPtr = JsValuePtr(new JsValue(jsEngine, localContext->Global()));
+    thisPtr = JsValue::Create(jsEngine, localContext->Global());
   }
   if (!thisPtr->IsObject())
     throw new std::runtime_error("`this` pointer has to be an object");
@@ -227,5 +371,5 @@ AdblockPlus::JsValuePtr AdblockPlus::JsValue::Call(const JsValueList& params, Js
   if (tryCatch.HasCaught())
     throw JsError(tryCatch.Exception(), tryCatch.Message());
 
-  return JsValuePtr(new JsValue(jsEngine, result));
+  return JsValue::Create(jsEngine, result);
 }
@@ -0,0 +1,150 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <AdblockPlus/LatencyHistogram.h>
+
+using namespace AdblockPlus;
+
+namespace
+{
+  int FloorLog2(uint64_t value)
+  {
+    int result = 0;
+    for (int shift = 32; shift; shift >>= 1)
+    {
+      if (value >> shift)
+      {
+        value >>= shift;
+        result += shift;
+      }
+    }
+    return result;
+  }
+
+  int64_t GetPercentile(const LatencyStatistics& statistics, double percentile)
+  {
+    int64_t count = 0;
+    for (size_t i = 0; i < statistics.buckets.size(); i++)
+      count += statistics.buckets[i].second;
+    const int64_t rank = static_cast<int64_t>(percentile / 100 * count);
+    int64_t seen = 0;
+    for (size_t i = 0; i < statistics.buckets.size(); i++)
+    {
+      seen += statistics.buckets[i].second;
+      if (seen > rank)
+        return std::min(statistics.buckets[i].first, statistics.maxTime);
+    }
+    return statistics.maxTime;
+  }
+}
+
+LatencyHistogram::Scope::Scope(LatencyHistogram& histogram)
+  : histogram(histogram), start(std::chrono::steady_clock::now())
+{
+}
+
+LatencyHistogram::Scope::~Scope()
+{
+  histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count());
+}
+
+LatencyHistogram::Shard::Shard()
+  : totalTime(0), maxTime(0)
+{
+  for (int i = 0; i < BUCKET_COUNT; i++)
+    buckets[i].store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram::LatencyHistogram()
+  : shards(new Shard[SHARD_COUNT])
+{
+}
+
+int LatencyHistogram::GetBucketIndex(int64_t nanoseconds)
+{
+  if (nanoseconds < SUB_BUCKET_COUNT)
+    return static_cast<int>(std::max<int64_t>(nanoseconds, 0));
+  const int64_t limit = static_cast<int64_t>(1) << (MAX_EXPONENT + 1);
+  if (nanoseconds >= limit)
+    nanoseconds = limit - 1;
+  const int exponent = FloorLog2(nanoseconds);
+  const int subBucket = static_cast<int>(
+      nanoseconds >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKET_COUNT;
+  return SUB_BUCKET_COUNT * (exponent - SUB_BUCKET_BITS + 1) + subBucket;
+}
+
+int64_t LatencyHistogram::GetBucketLimit(int index)
+{
+  if (index < SUB_BUCKET_COUNT)
+    return index;
+  const int exponent = index / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+  const int64_t subBucket = index % SUB_BUCKET_COUNT;
+  return ((SUB_BUCKET_COUNT + subBucket + 1) <<
+      (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+void LatencyHistogram::Record(int64_t nanoseconds)
+{
+  // Thread IDs are often aligned addresses, mix the hash so that the upper
+  // bits used for picking the shard differ.
+  const uint64_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+  Shard& shard = shards[(hash * 0x9E3779B97F4A7C15ULL) >> (64 - SHARD_BITS)];
+
+  shard.buckets[GetBucketIndex(nanoseconds)].fetch_add(1,
+      std::memory_order_relaxed);
+  shard.totalTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+  int64_t max = shard.maxTime.load(std::memory_order_relaxed);
+  while (nanoseconds > max &&
+         !shard.maxTime.compare_exchange_weak(max, nanoseconds,
+             std::memory_order_relaxed))
+  {
+  }
+}
+
+LatencyStatistics LatencyHistogram::GetStatistics() const
+{
+  LatencyStatistics result;
+  result.count = 0;
+  result.totalTime = 0;
+  result.maxTime = 0;
+  for (int i = 0; i < BUCKET_COUNT; i++)
+  {
+    int64_t count = 0;
+    for (int j = 0; j < SHARD_COUNT; j++)
+      count += shards[j].buckets[i].load(std::memory_order_relaxed);
+    if (count)
+    {
+      result.buckets.push_back(std::make_pair(GetBucketLimit(i), count));
+      result.count += count;
+    }
+  }
+  for (int i = 0; i < SHARD_COUNT; i++)
+  {
+    result.totalTime += shards[i].totalTime.load(std::memory_order_relaxed);
+    result.maxTime = std::max(result.maxTime,
+        shards[i].maxTime.load(std::memory_order_relaxed));
+  }
+  result.p50 = GetPercentile(result, 50);
+  result.p90 = GetPercentile(result, 90);
+  result.p99 = GetPercentile(result, 99);
+  result.p999 = GetPercentile(result, 99.9);
+  return result;
+}
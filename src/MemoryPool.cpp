@@ -0,0 +1,74 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "MemoryPool.h"
+
+namespace
+{
+  const std::size_t blocksPerChunk = 256;
+}
+
+AdblockPlus::MemoryPool::MemoryPool(std::size_t blockSize)
+  : blockSize(std::max(blockSize, sizeof(FreeBlock))), freeList(0),
+    returnedList(0)
+{
+}
+
+AdblockPlus::MemoryPool::~MemoryPool()
+{
+  for (std::vector<char*>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+    delete[] *it;
+}
+
+void* AdblockPlus::MemoryPool::Allocate()
+{
+  const Lock lock(mutex);
+  if (!freeList)
+    freeList = returnedList.exchange(0);
+  if (!freeList)
+  {
+    // Blocks are handed out in chunks, blockSize is rounded up so that all of
+    // them are suitably aligned.
+    const std::size_t alignment = sizeof(void*) * 2;
+    const std::size_t stride = (blockSize + alignment - 1) / alignment * alignment;
+    char* chunk = new char[stride * blocksPerChunk];
+    chunks.push_back(chunk);
+    for (std::size_t i = blocksPerChunk; i > 0; i--)
+    {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * stride);
+      block->next = freeList;
+      freeList = block;
+    }
+  }
+  FreeBlock* block = freeList;
+  freeList = block->next;
+  return block;
+}
+
+void AdblockPlus::MemoryPool::Free(void* block)
+{
+  if (!block)
+    return;
+  // Pushing onto a lock-free stack is safe from the ABA problem, unlike
+  // popping. Allocate() always takes the whole stack at once.
+  FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+  freeBlock->next = returnedList.load();
+  while (!returnedList.compare_exchange_weak(freeBlock->next, freeBlock))
+    ;
+}
@@ -0,0 +1,148 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_MEMORY_POOL_H
+#define ADBLOCK_PLUS_MEMORY_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "Thread.h"
+
+namespace AdblockPlus
+{
+  /**
+   * Allocator for blocks of a fixed size. Freed blocks are kept in a free list
+   * and reused, memory is only returned when the pool is destroyed.
+   * Blocks can be allocated and freed on any thread. Freeing doesn't lock,
+   * since JsValue instances are typically released outside of the engine
+   * lock while allocations are already serialized by it.
+   */
+  class MemoryPool
+  {
+  public:
+    explicit MemoryPool(std::size_t blockSize);
+    ~MemoryPool();
+    void* Allocate();
+    void Free(void* block);
+
+    std::size_t GetBlockSize() const
+    {
+      return blockSize;
+    }
+
+  private:
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    MemoryPool(const MemoryPool&);
+    MemoryPool& operator=(const MemoryPool&);
+
+    const std::size_t blockSize;
+    // Only accessed with mutex locked
+    FreeBlock* freeList;
+    std::vector<char*> chunks;
+    Mutex mutex;
+    // Blocks freed since the last time freeList ran empty
+    std::atomic<FreeBlock*> returnedList;
+  };
+
+  /**
+   * Standard allocator taking single objects from a `MemoryPool` when they
+   * fit into its blocks, for use with `std::allocate_shared()`. The pool has
+   * to outlive all objects allocated from it. It is referenced by a plain
+   * pointer since allocators are copied a lot, reference counting would
+   * cost more than the allocation itself.
+   */
+  template<typename T>
+  class PoolAllocator
+  {
+  public:
+    typedef T value_type;
+
+    explicit PoolAllocator(MemoryPool& pool)
+      : pool(&pool)
+    {
+    }
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other)
+      : pool(other.pool)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+      if (n == 1 && sizeof(T) <= pool->GetBlockSize())
+        return static_cast<T*>(pool->Allocate());
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+      if (n == 1 && sizeof(T) <= pool->GetBlockSize())
+        pool->Free(p);
+      else
+        ::operator delete(p);
+    }
+
+    // Explicit construct() so that classes can grant access to private
+    // constructors by befriending PoolAllocator.
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+      ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+      p->~U();
+    }
+
+    template<typename U>
+    struct rebind
+    {
+      typedef PoolAllocator<U> other;
+    };
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const
+    {
+      return pool == other.pool;
+    }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const
+    {
+      return pool != other.pool;
+    }
+
+  private:
+    template<typename U> friend class PoolAllocator;
+
+    MemoryPool* pool;
+  };
+}
+
+#endif
@@ -88,19 +88,12 @@ NotificationTexts Notification::GetTexts()
 
 std::vector<std::string> Notification::GetLinks() const
 {
-  std::vector<std::string> retValue;
   JsValuePtr jsLinks = GetProperty("links");
   if (!jsLinks->IsArray())
   {
-    return retValue;
-  }
-  JsValueList urlLinksList = jsLinks->AsList();
-  for (JsValueList::const_iterator linkIterator = urlLinksList.begin();
-    linkIterator != urlLinksList.end(); ++linkIterator)
-  {
-    retValue.push_back((*linkIterator)->AsString());
+    return std::vector<std::string>();
   }
-  return retValue;
+  return jsLinks->AsStringVector();
 }
 
 void Notification::MarkAsShown()
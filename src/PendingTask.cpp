@@ -0,0 +1,37 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PendingTask.h"
+
+using namespace AdblockPlus;
+
+PendingTask::PendingTask(const JsEnginePtr& jsEngine, Type type)
+  : jsEngine(jsEngine), type(type)
+{
+  GetCounter()++;
+}
+
+PendingTask::~PendingTask()
+{
+  GetCounter()--;
+}
+
+std::atomic<int>& PendingTask::GetCounter() const
+{
+  return type == TYPE_TIMER ? jsEngine->pendingTimers :
+      jsEngine->pendingIoThreads;
+}
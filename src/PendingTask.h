@@ -0,0 +1,48 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADBLOCK_PLUS_PENDING_TASK_H
+#define ADBLOCK_PLUS_PENDING_TASK_H
+
+#include <AdblockPlus/JsEngine.h>
+
+namespace AdblockPlus
+{
+  /**
+   * Counts an asynchronous operation of an engine as pending while it exists,
+   * see JsEngine::GetStatistics().
+   */
+  class PendingTask
+  {
+  public:
+    enum Type {TYPE_TIMER, TYPE_IO_THREAD};
+
+    PendingTask(const JsEnginePtr& jsEngine, Type type);
+    ~PendingTask();
+
+  private:
+    PendingTask(const PendingTask&);
+    PendingTask& operator=(const PendingTask&);
+
+    std::atomic<int>& GetCounter() const;
+
+    JsEnginePtr jsEngine;
+    Type type;
+  };
+}
+
+#endif
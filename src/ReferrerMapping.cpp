@@ -15,28 +15,49 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <AdblockPlus/ReferrerMapping.h>
 
 using namespace AdblockPlus;
 
-ReferrerMapping::ReferrerMapping(const int maxCachedUrls)
-  : maxCachedUrls(maxCachedUrls)
+ReferrerMapping::ReferrerMapping(const int maxCachedUrls,
+                                 const size_t maxCachedBytes)
+  : maxCachedUrls(maxCachedUrls), maxCachedBytes(maxCachedBytes),
+    cachedBytes(0), oldest(0), newest(0)
 {
 }
 
 void ReferrerMapping::Add(const std::string& url, const std::string& referrer)
 {
-  if (mapping.find(url) != mapping.end())
-    cachedUrls.remove(url);
-  cachedUrls.push_back(url);
-  mapping[url] = referrer;
+  EntryMap::iterator it = entries.find(&url);
+  if (it != entries.end())
+  {
+    Entry& entry = it->second;
+    Unlink(entry);
+    Link(entry);
+    if (entry.referrer->first != referrer)
+    {
+      cachedBytes += referrer.size() - entry.referrer->first.size();
+      const StringRef previousReferrer = entry.referrer;
+      entry.referrer = Intern(referrer);
+      Release(previousReferrer);
+    }
+  }
+  else
+  {
+    Entry entry;
+    entry.url = Intern(url);
+    entry.referrer = Intern(referrer);
+    entry.sequence = 0;
+    Link(entries.insert(std::make_pair(&entry.url->first, entry)).first->second);
+    cachedBytes += url.size() + referrer.size();
+  }
 
-  const int urlsToPop = cachedUrls.size() - maxCachedUrls;
-  for (int i = 0; i < urlsToPop; i++)
+  while (!entries.empty() &&
+         (static_cast<int>(entries.size()) > maxCachedUrls ||
+          (maxCachedBytes && cachedBytes > maxCachedBytes)))
   {
-    const std::string poppedUrl = cachedUrls.front();
-    cachedUrls.pop_front();
-    mapping.erase(poppedUrl);
+    RemoveOldest();
   }
 }
 
@@ -48,13 +69,66 @@ std::vector<std::string> ReferrerMapping::BuildReferrerChain(
   // We need to limit the chain length to ensure we don't block indefinitely
   // if there's a referrer loop.
   const int maxChainLength = 10;
-  std::map<std::string, std::string>::const_iterator currentEntry =
-    mapping.find(url);
-  for (int i = 0; i < maxChainLength && currentEntry != mapping.end(); i++)
+  const std::string* currentUrl = FindReferrer(url);
+  for (int i = 0; i < maxChainLength && currentUrl; i++)
   {
-    const std::string& currentUrl = currentEntry->second;
-    referrerChain.insert(referrerChain.begin(), currentUrl);
-    currentEntry = mapping.find(currentUrl);
+    referrerChain.push_back(*currentUrl);
+    currentUrl = FindReferrer(*currentUrl);
   }
+  std::reverse(referrerChain.begin(), referrerChain.end());
   return referrerChain;
 }
+
+const std::string* ReferrerMapping::FindReferrer(const std::string& url) const
+{
+  EntryMap::const_iterator it = entries.find(&url);
+  return it != entries.end() ? &it->second.referrer->first : 0;
+}
+
+ReferrerMapping::StringRef ReferrerMapping::Intern(const std::string& str)
+{
+  StringRef result = &*strings.insert(std::make_pair(str, 0)).first;
+  result->second++;
+  return result;
+}
+
+void ReferrerMapping::Release(StringRef str)
+{
+  if (!--str->second)
+    strings.erase(str->first);
+}
+
+void ReferrerMapping::Link(Entry& entry)
+{
+  entry.previous = newest;
+  entry.next = 0;
+  if (newest)
+    newest->next = &entry;
+  else
+    oldest = &entry;
+  newest = &entry;
+}
+
+void ReferrerMapping::Unlink(Entry& entry)
+{
+  if (entry.previous)
+    entry.previous->next = entry.next;
+  else
+    oldest = entry.next;
+  if (entry.next)
+    entry.next->previous = entry.previous;
+  else
+    newest = entry.previous;
+}
+
+void ReferrerMapping::RemoveOldest()
+{
+  Entry& entry = *oldest;
+  Unlink(entry);
+  cachedBytes -= entry.url->first.size() + entry.referrer->first.size();
+  const StringRef url = entry.url;
+  const StringRef referrer = entry.referrer;
+  entries.erase(&url->first);
+  Release(referrer);
+  Release(url);
+}
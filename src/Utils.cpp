@@ -17,6 +17,7 @@
 
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -27,6 +28,45 @@
 
 using namespace AdblockPlus;
 
+namespace
+{
+  // Below this length copying is cheaper than tracking an external resource.
+  const std::string::size_type minExternalStringLength = 1024;
+
+  class ExternalStdString : public v8::String::ExternalOneByteStringResource
+  {
+  public:
+    explicit ExternalStdString(std::string&& str)
+      : str(std::move(str))
+    {
+    }
+
+    const char* data() const
+    {
+      return str.data();
+    }
+
+    size_t length() const
+    {
+      return str.length();
+    }
+
+  private:
+    const std::string str;
+  };
+
+  bool IsAscii(const std::string& str, std::string::size_type offset = 0)
+  {
+    for (std::string::const_iterator it = str.begin() + offset;
+         it != str.end(); ++it)
+    {
+      if (static_cast<unsigned char>(*it) >= 0x80)
+        return false;
+    }
+    return true;
+  }
+}
+
 std::string Utils::Slurp(std::istream& stream)
 {
   std::stringstream content;
@@ -36,11 +76,47 @@ std::string Utils::Slurp(std::istream& stream)
 
 std::string Utils::FromV8String(v8::Handle<v8::Value> value)
 {
-  v8::String::Utf8Value stringValue(value);
-  if (stringValue.length())
-    return std::string(*stringValue, stringValue.length());
-  else
-    return std::string();
+  std::string result;
+  AppendV8String(result, value);
+  return result;
+}
+
+void Utils::AppendV8String(std::string& buffer, v8::Handle<v8::Value> value)
+{
+  if (value.IsEmpty())
+    return;
+
+  if (!value->IsString())
+  {
+    // Conversion might call into JavaScript and throw, Utf8Value deals with
+    // that for us.
+    v8::String::Utf8Value stringValue(value);
+    if (stringValue.length())
+      buffer.append(*stringValue, stringValue.length());
+    return;
+  }
+
+  const v8::Handle<v8::String> str = v8::Handle<v8::String>::Cast(value);
+  const std::string::size_type offset = buffer.size();
+  if (str->IsOneByte())
+  {
+    // Most strings we get are ASCII, these can be copied as they are. Latin-1
+    // characters outside of ASCII need to be encoded, fall through for these.
+    const int length = str->Length();
+    buffer.resize(offset + length);
+    if (length)
+      str->WriteOneByte(reinterpret_cast<uint8_t*>(&buffer[offset]), 0, length,
+          v8::String::NO_NULL_TERMINATION);
+    if (IsAscii(buffer, offset))
+      return;
+    buffer.resize(offset);
+  }
+
+  const int utf8Length = str->Utf8Length();
+  buffer.resize(offset + utf8Length);
+  if (utf8Length)
+    str->WriteUtf8(&buffer[offset], utf8Length, 0,
+        v8::String::NO_NULL_TERMINATION);
 }
 
 v8::Local<v8::String> Utils::ToV8String(v8::Isolate* isolate, const std::string& str)
@@ -49,11 +125,26 @@ v8::Local<v8::String> Utils::ToV8String(v8::Isolate* isolate, const std::string&
     v8::String::NewStringType::kNormalString, str.length());
 }
 
+v8::Local<v8::String> Utils::ToV8String(v8::Isolate* isolate, std::string&& str)
+{
+  // V8 expects Latin-1 for one-byte external strings, which only matches our
+  // UTF-8 data if it is plain ASCII. Anything else has to be decoded by V8.
+  if (str.length() < minExternalStringLength || !IsAscii(str))
+    return ToV8String(isolate, static_cast<const std::string&>(str));
+  return v8::String::NewExternal(isolate, new ExternalStdString(std::move(str)));
+}
+
 void Utils::ThrowException(v8::Isolate* isolate, const std::string& str)
 {
 	isolate->ThrowException(Utils::ToV8String(isolate, str));
 }
 
+int64_t Utils::MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
 #ifdef _WIN32
 std::wstring Utils::ToUtf16String(const std::string& str)
 {
@@ -20,8 +20,10 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <functional>
 #include <istream>
+#include <stdint.h>
 #include <string>
 #include <v8.h>
 
@@ -31,8 +33,15 @@ namespace AdblockPlus
   {
     std::string Slurp(std::istream& stream);
     std::string FromV8String(v8::Handle<v8::Value> value);
+    // Appends the UTF-8 representation of value to buffer.
+    void AppendV8String(std::string& buffer, v8::Handle<v8::Value> value);
     v8::Local<v8::String> ToV8String(v8::Isolate* isolate, const std::string& str);
+    // Takes ownership of the buffer: large ASCII strings are handed to V8 as
+    // external strings instead of being copied into the heap.
+    v8::Local<v8::String> ToV8String(v8::Isolate* isolate, std::string&& str);
 	void ThrowException(v8::Isolate* isolate, const std::string& str);
+    // Returns the time elapsed since start in microseconds.
+    int64_t MicrosecondsSince(std::chrono::steady_clock::time_point start);
     // Code for templated function has to be in a header file, can't be in .cpp
     template<class T>
     T TrimString(T text)
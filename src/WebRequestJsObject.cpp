@@ -20,17 +20,24 @@
 #include <AdblockPlus/WebRequest.h>
 
 #include "JsContext.h"
+#include "PendingTask.h"
 #include "Thread.h"
 #include "Utils.h"
 #include "WebRequestJsObject.h"
 
 namespace
 {
+  const AdblockPlus::PropertyName statusName("status");
+  const AdblockPlus::PropertyName responseStatusName("responseStatus");
+  const AdblockPlus::PropertyName responseTextName("responseText");
+  const AdblockPlus::PropertyName responseHeadersName("responseHeaders");
+
   class WebRequestThread : public AdblockPlus::Thread
   {
   public:
     WebRequestThread(AdblockPlus::JsEnginePtr jsEngine, AdblockPlus::JsValueList& arguments)
-        : jsEngine(jsEngine), url(arguments[0]->AsString())
+        : jsEngine(jsEngine), url(arguments[0]->AsString()),
+          pendingTask(jsEngine, AdblockPlus::PendingTask::TYPE_IO_THREAD)
     {
       if (!url.length())
         throw std::runtime_error("Invalid string passed as first argument to GET");
@@ -63,9 +70,9 @@ namespace
       AdblockPlus::JsContext context(jsEngine);
 
       AdblockPlus::JsValuePtr resultObject = jsEngine->NewObject();
-      resultObject->SetProperty("status", result.status);
-      resultObject->SetProperty("responseStatus", result.responseStatus);
-      resultObject->SetProperty("responseText", result.responseText);
+      resultObject->SetProperty(statusName, result.status);
+      resultObject->SetProperty(responseStatusName, result.responseStatus);
+      resultObject->SetProperty(responseTextName, std::move(result.responseText));
 
       AdblockPlus::JsValuePtr headersObject = jsEngine->NewObject();
       for (AdblockPlus::HeaderList::iterator it = result.responseHeaders.begin();
@@ -73,7 +80,7 @@ namespace
       {
         headersObject->SetProperty(it->first, it->second);
       }
-      resultObject->SetProperty("responseHeaders", headersObject);
+      resultObject->SetProperty(responseHeadersName, headersObject);
 
       AdblockPlus::JsValueList params;
       params.push_back(resultObject);
@@ -86,6 +93,7 @@ namespace
     std::string url;
     AdblockPlus::HeaderList headers;
     AdblockPlus::JsValuePtr callback;
+    AdblockPlus::PendingTask pendingTask;
   };
 
   void GETCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
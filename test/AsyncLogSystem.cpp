@@ -0,0 +1,148 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+#include <AdblockPlus.h>
+#include <gtest/gtest.h>
+
+#include "../src/Thread.h"
+
+namespace
+{
+  class CollectingLogSystem : public AdblockPlus::LogSystem
+  {
+  public:
+    CollectingLogSystem()
+      : blocked(false)
+    {
+    }
+
+    void operator()(LogLevel logLevel, const std::string& message,
+          const std::string& source)
+    {
+      while (blocked)
+        AdblockPlus::Sleep(1);
+      std::lock_guard<std::mutex> lock(mutex);
+      messages.push_back(message);
+      sources.push_back(source);
+    }
+
+    bool IsEnabled(LogLevel logLevel) const
+    {
+      return logLevel >= LOG_LEVEL_WARN;
+    }
+
+    bool NeedsSource() const
+    {
+      return false;
+    }
+
+    std::vector<std::string> GetMessages()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return messages;
+    }
+
+    std::atomic<bool> blocked;
+
+  private:
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    std::vector<std::string> sources;
+  };
+
+  typedef std::shared_ptr<CollectingLogSystem> CollectingLogSystemPtr;
+
+  class LogThread : public AdblockPlus::Thread
+  {
+  public:
+    explicit LogThread(AdblockPlus::LogSystem& logSystem)
+      : logSystem(logSystem)
+    {
+    }
+
+    void Run()
+    {
+      for (int i = 0; i < 100; i++)
+        logSystem(AdblockPlus::LogSystem::LOG_LEVEL_ERROR, "message", "");
+    }
+
+  private:
+    AdblockPlus::LogSystem& logSystem;
+  };
+}
+
+TEST(AsyncLogSystemTest, MessagesArePassedOn)
+{
+  CollectingLogSystemPtr target(new CollectingLogSystem());
+  AdblockPlus::AsyncLogSystem logSystem(target);
+  logSystem(AdblockPlus::LogSystem::LOG_LEVEL_WARN, "first", "source");
+  logSystem(AdblockPlus::LogSystem::LOG_LEVEL_ERROR, "second", "");
+  logSystem.Flush();
+  std::vector<std::string> messages = target->GetMessages();
+  ASSERT_EQ(2u, messages.size());
+  ASSERT_EQ("first", messages[0]);
+  ASSERT_EQ("second", messages[1]);
+}
+
+TEST(AsyncLogSystemTest, LevelsAndSourceAreForwarded)
+{
+  CollectingLogSystemPtr target(new CollectingLogSystem());
+  AdblockPlus::AsyncLogSystem logSystem(target);
+  ASSERT_FALSE(logSystem.IsEnabled(AdblockPlus::LogSystem::LOG_LEVEL_INFO));
+  ASSERT_TRUE(logSystem.IsEnabled(AdblockPlus::LogSystem::LOG_LEVEL_ERROR));
+  ASSERT_FALSE(logSystem.NeedsSource());
+
+  logSystem(AdblockPlus::LogSystem::LOG_LEVEL_INFO, "info", "");
+  logSystem.Flush();
+  ASSERT_EQ(0u, target->GetMessages().size());
+}
+
+TEST(AsyncLogSystemTest, MessagesAreDroppedWhenFull)
+{
+  CollectingLogSystemPtr target(new CollectingLogSystem());
+  target->blocked = true;
+  {
+    AdblockPlus::AsyncLogSystem logSystem(target, 4);
+    for (int i = 0; i < 10; i++)
+      logSystem(AdblockPlus::LogSystem::LOG_LEVEL_ERROR, "message", "");
+    // A slot is only released once its message has been written, so the
+    // background thread can't make room while it is blocked.
+    ASSERT_EQ(6, logSystem.GetDroppedMessageCount());
+    target->blocked = false;
+  }
+  ASSERT_EQ(4u, target->GetMessages().size());
+}
+
+TEST(AsyncLogSystemTest, ConcurrentLogging)
+{
+  CollectingLogSystemPtr target(new CollectingLogSystem());
+  AdblockPlus::AsyncLogSystem logSystem(target, 1024);
+  std::vector<LogThread*> threads;
+  for (int i = 0; i < 4; i++)
+    threads.push_back(new LogThread(logSystem));
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i]->Start();
+  for (size_t i = 0; i < threads.size(); i++)
+  {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  logSystem.Flush();
+  ASSERT_EQ(400u,
+      target->GetMessages().size() + logSystem.GetDroppedMessageCount());
+}
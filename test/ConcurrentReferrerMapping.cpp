@@ -0,0 +1,148 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <AdblockPlus.h>
+#include <gtest/gtest.h>
+
+#include "../src/Thread.h"
+
+namespace
+{
+  class AddThread : public AdblockPlus::Thread
+  {
+  public:
+    AddThread(AdblockPlus::ConcurrentReferrerMapping& referrerMapping,
+              int index)
+      : referrerMapping(referrerMapping), index(index)
+    {
+    }
+
+    void Run()
+    {
+      for (int i = 0; i < 1000; i++)
+      {
+        std::stringstream url;
+        std::stringstream referrer;
+        url << "thread" << index << "/url" << i + 1;
+        referrer << "thread" << index << "/url" << i;
+        referrerMapping.Add(url.str(), referrer.str());
+        referrerMapping.BuildReferrerChain(url.str());
+      }
+    }
+
+  private:
+    AdblockPlus::ConcurrentReferrerMapping& referrerMapping;
+    int index;
+  };
+}
+
+TEST(ConcurrentReferrerMappingTest, ReferrerChain)
+{
+  AdblockPlus::ConcurrentReferrerMapping referrerMapping;
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("third", "second");
+  std::vector<std::string> referrerChain =
+    referrerMapping.BuildReferrerChain("third");
+  ASSERT_EQ(3u, referrerChain.size());
+  ASSERT_EQ("first", referrerChain[0]);
+  ASSERT_EQ("second", referrerChain[1]);
+  ASSERT_EQ("third", referrerChain[2]);
+  ASSERT_EQ(1u, referrerMapping.BuildReferrerChain("first").size());
+}
+
+TEST(ConcurrentReferrerMappingTest, UrlsAreOnlyDroppedWhenFull)
+{
+  // Five URLs have to be kept, no matter how they are distributed over the
+  // shards.
+  AdblockPlus::ConcurrentReferrerMapping referrerMapping(5);
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("third", "second");
+  referrerMapping.Add("fourth", "third");
+  referrerMapping.Add("fifth", "fourth");
+  referrerMapping.Add("sixth", "fifth");
+  ASSERT_EQ(6u, referrerMapping.BuildReferrerChain("sixth").size());
+
+  referrerMapping.Add("seventh", "sixth");
+  const char* urls[] = {"second", "third", "fourth", "fifth", "sixth", "seventh"};
+  int knownUrls = 0;
+  for (size_t i = 0; i < sizeof(urls) / sizeof(urls[0]); i++)
+  {
+    if (referrerMapping.BuildReferrerChain(urls[i]).size() > 1)
+      knownUrls++;
+  }
+  ASSERT_EQ(5, knownUrls);
+  ASSERT_EQ(1u, referrerMapping.BuildReferrerChain("second").size());
+}
+
+TEST(ConcurrentReferrerMappingTest, LeastRecentlyAddedUrlsAreDropped)
+{
+  const int maxCachedUrls = 100;
+  AdblockPlus::ConcurrentReferrerMapping referrerMapping(maxCachedUrls);
+  for (int i = 0; i < 1000; i++)
+  {
+    std::stringstream url;
+    url << "url" << i;
+    referrerMapping.Add(url.str(), "referrer");
+    ASSERT_EQ(2u, referrerMapping.BuildReferrerChain(url.str()).size());
+
+    // Exactly the most recently added URLs are known
+    for (int j = std::max(0, i - maxCachedUrls - 10); j <= i; j++)
+    {
+      std::stringstream knownUrl;
+      knownUrl << "url" << j;
+      ASSERT_EQ(j > i - maxCachedUrls ? 2u : 1u,
+                referrerMapping.BuildReferrerChain(knownUrl.str()).size());
+    }
+  }
+}
+
+TEST(ConcurrentReferrerMappingTest, ReaddedUrlsAreDroppedLast)
+{
+  AdblockPlus::ConcurrentReferrerMapping referrerMapping(3);
+  referrerMapping.Add("first", "referrer");
+  referrerMapping.Add("second", "referrer");
+  referrerMapping.Add("third", "referrer");
+  referrerMapping.Add("first", "referrer");
+  referrerMapping.Add("fourth", "referrer");
+  ASSERT_EQ(2u, referrerMapping.BuildReferrerChain("first").size());
+  ASSERT_EQ(1u, referrerMapping.BuildReferrerChain("second").size());
+  ASSERT_EQ(2u, referrerMapping.BuildReferrerChain("third").size());
+  ASSERT_EQ(2u, referrerMapping.BuildReferrerChain("fourth").size());
+}
+
+TEST(ConcurrentReferrerMappingTest, ConcurrentAccess)
+{
+  AdblockPlus::ConcurrentReferrerMapping referrerMapping(2000, 0, 4);
+  std::vector<AddThread*> threads;
+  for (int i = 0; i < 4; i++)
+    threads.push_back(new AddThread(referrerMapping, i));
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i]->Start();
+  for (size_t i = 0; i < threads.size(); i++)
+  {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  // The most recent URLs of each thread are still known
+  std::vector<std::string> referrerChain =
+    referrerMapping.BuildReferrerChain("thread2/url1000");
+  ASSERT_EQ(11u, referrerChain.size());
+  ASSERT_EQ("thread2/url990", referrerChain[0]);
+}
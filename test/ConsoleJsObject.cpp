@@ -37,6 +37,20 @@ namespace
 
   typedef std::shared_ptr<MockLogSystem> MockLogSystemPtr;
 
+  class FilteringLogSystem : public MockLogSystem
+  {
+  public:
+    bool IsEnabled(AdblockPlus::LogSystem::LogLevel logLevel) const
+    {
+      return logLevel >= AdblockPlus::LogSystem::LOG_LEVEL_WARN;
+    }
+
+    bool NeedsSource() const
+    {
+      return false;
+    }
+  };
+
   class ConsoleJsObjectTest : public BaseJsTest
   {
   protected:
@@ -108,3 +122,20 @@ TEST_F(ConsoleJsObjectTest, ConsoleTraceCall)
 3: /* anonymous */() at eval:8\n", mockLogSystem->lastMessage);
   ASSERT_EQ("", mockLogSystem->lastSource);
 }
+
+TEST_F(ConsoleJsObjectTest, LevelFilteringAndNoSource)
+{
+  MockLogSystemPtr filteringLogSystem(new FilteringLogSystem);
+  jsEngine->SetLogSystem(filteringLogSystem);
+  jsEngine->Evaluate("console.warn('foo', 'bar')");
+  ASSERT_EQ(AdblockPlus::LogSystem::LOG_LEVEL_WARN, filteringLogSystem->lastLogLevel);
+  ASSERT_EQ("foo bar", filteringLogSystem->lastMessage);
+  ASSERT_EQ("", filteringLogSystem->lastSource);
+
+  // Arguments of filtered calls are never converted
+  jsEngine->Evaluate("var converted = false;\n"
+      "console.log({toString: function() { converted = true; }});\n"
+      "console.trace();");
+  ASSERT_EQ("foo bar", filteringLogSystem->lastMessage);
+  ASSERT_FALSE(jsEngine->Evaluate("converted")->AsBool());
+}
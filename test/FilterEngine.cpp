@@ -15,6 +15,8 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include "BaseJsTest.h"
 
 namespace
@@ -124,6 +126,12 @@ TEST_F(FilterEngineTest, FilterCreation)
   ASSERT_EQ(AdblockPlus::Filter::TYPE_ELEMHIDE_EXCEPTION, filter4->GetType());
   AdblockPlus::FilterPtr filter5 = filterEngine->GetFilter("  foo  ");
   ASSERT_EQ(*filter1, *filter5);
+  ASSERT_EQ("foo", filter5->GetText());
+  AdblockPlus::FilterPtr filter6 = filterEngine->GetFilter("! foo");
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_COMMENT, filter6->GetType());
+  AdblockPlus::FilterPtr filter7 = filterEngine->GetFilter("foo$nonexistentoption");
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_INVALID, filter7->GetType());
+  ASSERT_EQ("foo$nonexistentoption", filter7->GetText());
 }
 
 TEST_F(FilterEngineTest, FilterProperties)
@@ -164,6 +172,105 @@ TEST_F(FilterEngineTest, AddRemoveFilters)
   ASSERT_FALSE(filter->IsListed());
 }
 
+TEST_F(FilterEngineTest, FilterCount)
+{
+  const int count = filterEngine->GetFilterCount();
+  AdblockPlus::FilterPtr filter = filterEngine->GetFilter("foo");
+  ASSERT_EQ(count, filterEngine->GetFilterCount());
+  filter->AddToList();
+  ASSERT_EQ(count + 1, filterEngine->GetFilterCount());
+  filterEngine->GetFilter("bar")->AddToList();
+  ASSERT_EQ(count + 2, filterEngine->GetFilterCount());
+  filter->RemoveFromList();
+  ASSERT_EQ(count + 1, filterEngine->GetFilterCount());
+}
+
+TEST_F(FilterEngineTest, StartupReport)
+{
+  const AdblockPlus::FilterEngineStartupReport& report =
+    filterEngine->GetStartupReport();
+  ASSERT_LT(0u, report.scriptEvaluation.size());
+  ASSERT_EQ("compat.js", report.scriptEvaluation.front().first);
+  ASSERT_LT(0, report.jsEngine.contextCreation);
+
+  int64_t evaluation = 0;
+  for (size_t i = 0; i < report.scriptEvaluation.size(); i++)
+    evaluation += report.scriptEvaluation[i].second;
+  ASSERT_LE(evaluation, report.filtersLoaded);
+  ASSERT_LE(evaluation, report.prefsLoaded);
+  ASSERT_LE(report.filtersLoaded, report.matchersPopulated);
+  ASSERT_LE(report.matchersPopulated, report.initialized);
+  ASSERT_LE(report.prefsLoaded, report.initialized);
+  ASSERT_LE(report.initialized, report.total);
+}
+
+TEST_F(FilterEngineTest, FilterIds)
+{
+  AdblockPlus::FilterPtr filter1 = filterEngine->GetFilter("foo");
+  AdblockPlus::FilterPtr filter2 = filterEngine->GetFilter("@@bar");
+  filter2->AddToList();
+  filter1->AddToList();
+
+  // IDs are assigned when filters are created, adding them doesn't matter
+  const int id2 = filter2->GetId();
+  const int id1 = filter1->GetId();
+  ASSERT_LT(0, id1);
+  ASSERT_EQ(id1 + 1, id2);
+  ASSERT_EQ(id1, filterEngine->GetFilter("foo")->GetId());
+
+  ASSERT_EQ("foo", filterEngine->GetFilterText(id1));
+  ASSERT_EQ("@@bar", filterEngine->GetFilterText(id2));
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_BLOCKING, filterEngine->GetFilterType(id1));
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_EXCEPTION, filterEngine->GetFilterType(id2));
+  ASSERT_EQ(1u, filterEngine->GetFilterSubscriptions(id1).size());
+  ASSERT_EQ(0, filterEngine->GetFilterHitCount(id1));
+
+  filter1->RemoveFromList();
+  ASSERT_EQ(id1, filter1->GetId());
+  ASSERT_EQ(0u, filterEngine->GetFilterSubscriptions(id1).size());
+
+  // Filters that were never added have an ID as well
+  AdblockPlus::FilterPtr filter3 = filterEngine->GetFilter("baz");
+  ASSERT_FALSE(filter3->IsListed());
+  const int id3 = filter3->GetId();
+  ASSERT_LT(id2, id3);
+  ASSERT_EQ("baz", filterEngine->GetFilterText(id3));
+
+  ASSERT_THROW(filterEngine->GetFilterText(0), std::invalid_argument);
+  ASSERT_THROW(filterEngine->GetFilterType(id3 + 1000), std::invalid_argument);
+  ASSERT_THROW(filterEngine->GetFilterSubscriptions(-1), std::invalid_argument);
+  ASSERT_THROW(filterEngine->GetFilterHitCount(id3 + 1000), std::invalid_argument);
+}
+
+TEST_F(FilterEngineTest, WrappersAreReused)
+{
+  AdblockPlus::FilterPtr filter = filterEngine->GetFilter("adbanner.gif");
+  filter->AddToList();
+  ASSERT_EQ(filter, filterEngine->GetFilter("adbanner.gif"));
+  ASSERT_EQ(filter, filterEngine->GetFilter("  adbanner.gif"));
+  ASSERT_EQ(filter, filterEngine->Matches("http://example.com/adbanner.gif",
+      AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, ""));
+  std::vector<AdblockPlus::FilterPtr> filters = filterEngine->GetListedFilters();
+  ASSERT_EQ(1u, filters.size());
+  ASSERT_EQ(filter, filters[0]);
+
+  // Wrappers are only cached while referenced
+  std::weak_ptr<AdblockPlus::Filter> weakFilter(filter);
+  filter.reset();
+  filters.clear();
+  ASSERT_TRUE(weakFilter.expired());
+  filter = filterEngine->GetFilter("adbanner.gif");
+  ASSERT_EQ("adbanner.gif", filter->GetText());
+
+  AdblockPlus::SubscriptionPtr subscription = filterEngine->GetSubscription("foo");
+  subscription->AddToList();
+  ASSERT_EQ(subscription, filterEngine->GetSubscription("foo"));
+  std::vector<AdblockPlus::SubscriptionPtr> subscriptions =
+    filterEngine->GetListedSubscriptions();
+  ASSERT_NE(subscriptions.end(),
+      std::find(subscriptions.begin(), subscriptions.end(), subscription));
+}
+
 TEST_F(FilterEngineTest, SubscriptionProperties)
 {
   AdblockPlus::SubscriptionPtr subscription = filterEngine->GetSubscription("foo");
@@ -262,6 +369,18 @@ TEST_F(FilterEngineTest, Matches)
   ASSERT_EQ(AdblockPlus::Filter::TYPE_BLOCKING, match12->GetType());
 }
 
+TEST_F(FilterEngineTest, MatchesAfterMemoryPressure)
+{
+  filterEngine->GetFilter("adbanner.gif")->AddToList();
+  const std::string url = "http://example.org/adbanner.gif";
+  ASSERT_TRUE(filterEngine->Matches(url, AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, ""));
+  ASSERT_LT(0, jsEngine->Evaluate("require('matcher').defaultMatcher.cacheEntries")->AsInt());
+
+  jsEngine->NotifyMemoryPressure(AdblockPlus::JsEngine::MEMORY_PRESSURE_CRITICAL);
+  ASSERT_EQ(0, jsEngine->Evaluate("require('matcher').defaultMatcher.cacheEntries")->AsInt());
+  ASSERT_TRUE(filterEngine->Matches(url, AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, ""));
+}
+
 TEST_F(FilterEngineTest, MatchesOnWhitelistedDomain)
 {
   filterEngine->GetFilter("adbanner.gif")->AddToList();
@@ -313,6 +432,53 @@ TEST_F(FilterEngineTest, MatchesNestedFrameRequest)
   ASSERT_EQ(AdblockPlus::Filter::TYPE_BLOCKING, match3->GetType());
 }
 
+TEST_F(FilterEngineTest, MatchResult)
+{
+  filterEngine->GetFilter("adbanner.gif")->AddToList();
+  filterEngine->GetFilter("nocollapse.gif$~collapse")->AddToList();
+  filterEngine->GetFilter("@@adbanner.gif$domain=example.org")->AddToList();
+
+  std::vector<std::string> documentUrls;
+  AdblockPlus::MatchResult result;
+  ASSERT_FALSE(filterEngine->Matches("http://example.com/foobar.gif",
+      AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, documentUrls, result));
+  ASSERT_EQ(AdblockPlus::MatchResult::DECISION_NONE, result.decision);
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_INVALID, result.filterType);
+  ASSERT_EQ(0, result.filterId);
+  ASSERT_FALSE(result.text);
+
+  documentUrls.push_back("http://example.com/");
+  ASSERT_TRUE(filterEngine->Matches("http://example.com/adbanner.gif",
+      AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, documentUrls, result));
+  ASSERT_EQ(AdblockPlus::MatchResult::DECISION_BLOCK, result.decision);
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_BLOCKING, result.filterType);
+  ASSERT_TRUE(result.collapse);
+  ASSERT_TRUE(result.text);
+  ASSERT_EQ("adbanner.gif", *result.text);
+  const int blockingId = result.filterId;
+  ASSERT_NE(0, blockingId);
+
+  ASSERT_TRUE(filterEngine->Matches("http://example.com/adbanner.gif",
+      AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, documentUrls, result));
+  ASSERT_EQ(blockingId, result.filterId);
+
+  ASSERT_TRUE(filterEngine->Matches("http://example.com/nocollapse.gif",
+      AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, documentUrls, result));
+  ASSERT_EQ(AdblockPlus::MatchResult::DECISION_BLOCK, result.decision);
+  ASSERT_FALSE(result.collapse);
+  ASSERT_NE(blockingId, result.filterId);
+
+  documentUrls.clear();
+  documentUrls.push_back("http://ads.com/frame/");
+  documentUrls.push_back("http://example.org/");
+  ASSERT_TRUE(filterEngine->Matches("http://ads.com/adbanner.gif",
+      AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, documentUrls, result));
+  ASSERT_EQ(AdblockPlus::MatchResult::DECISION_ALLOW, result.decision);
+  ASSERT_EQ(AdblockPlus::Filter::TYPE_EXCEPTION, result.filterType);
+  ASSERT_FALSE(result.collapse);
+  ASSERT_EQ("@@adbanner.gif$domain=example.org", *result.text);
+}
+
 TEST_F(FilterEngineTest, MatchesNestedFrameOnWhitelistedDomain)
 {
   filterEngine->GetFilter("adbanner.gif")->AddToList();
@@ -388,6 +554,50 @@ TEST_F(FilterEngineTest, SetRemoveFilterChangeCallback)
   EXPECT_EQ(2, timesCalled);
 }
 
+TEST_F(FilterEngineTest, Statistics)
+{
+  int timesCalled = 0;
+  MockFilterChangeCallback mockFilterChangeCallback(timesCalled);
+  filterEngine->SetFilterChangeCallback(mockFilterChangeCallback);
+  filterEngine->GetFilter("adbanner.gif")->AddToList();
+  filterEngine->GetFilter("##.ad")->AddToList();
+
+  const AdblockPlus::FilterEngineStatistics initial =
+    filterEngine->GetStatistics();
+  ASSERT_EQ(timesCalled, initial.filterChangeCallback.count);
+
+  std::vector<std::string> documentUrls;
+  documentUrls.push_back("http://example.com/");
+  AdblockPlus::MatchResult result;
+  for (int i = 0; i < 2; i++)
+  {
+    ASSERT_TRUE(filterEngine->Matches("http://example.com/adbanner.gif",
+        AdblockPlus::FilterEngine::CONTENT_TYPE_IMAGE, documentUrls, result));
+  }
+  ASSERT_FALSE(filterEngine->IsDocumentWhitelisted("http://example.com/",
+      std::vector<std::string>()));
+  filterEngine->GetElementHidingSelectors("example.com");
+
+  const AdblockPlus::FilterEngineStatistics stats =
+    filterEngine->GetStatistics();
+  // Whitelist checks aren't counted as Matches() calls
+  ASSERT_EQ(initial.matches.count + 2, stats.matches.count);
+  ASSERT_LE(initial.checkFilterMatch.count + 5, stats.checkFilterMatch.count);
+  ASSERT_EQ(initial.isDocumentWhitelisted.count + 1,
+            stats.isDocumentWhitelisted.count);
+  ASSERT_EQ(initial.getElementHidingSelectors.count + 1,
+            stats.getElementHidingSelectors.count);
+  ASSERT_LT(0, stats.matches.maxTime);
+  ASSERT_LE(stats.matches.p50, stats.matches.maxTime);
+  ASSERT_LE(stats.matches.maxTime, stats.matches.totalTime);
+
+  // The second lookups are answered from the caches
+  ASSERT_LE(initial.matcherCacheHits + 2, stats.matcherCacheHits);
+  ASSERT_LE(initial.matcherCacheMisses + 2, stats.matcherCacheMisses);
+  ASSERT_LE(initial.filterInfoCacheHits + 1, stats.filterInfoCacheHits);
+  ASSERT_LT(initial.jsEngine.lockCount, stats.jsEngine.lockCount);
+}
+
 TEST_F(UpdaterTest, SetRemoveUpdateAvailableCallback)
 {
   mockWebRequest->response.status = 0;
@@ -17,6 +17,7 @@
 
 #include <stdexcept>
 #include "BaseJsTest.h"
+#include "../src/Thread.h"
 
 namespace
 {
@@ -102,6 +103,26 @@ TEST_F(JsEngineTest, EventCallbacks)
   ASSERT_FALSE(callbackCalled);
 }
 
+TEST_F(JsEngineTest, CallbacksFindTheirEngine)
+{
+  // Both engines share the isolate, callbacks need to tell them apart
+  AdblockPlus::JsEnginePtr otherEngine = createJsEngine();
+  int calls = 0;
+  int otherCalls = 0;
+  jsEngine->SetEventCallback("foobar",
+      [&calls](const AdblockPlus::JsValueList&) { calls++; });
+  otherEngine->SetEventCallback("foobar",
+      [&otherCalls](const AdblockPlus::JsValueList&) { otherCalls++; });
+
+  otherEngine->Evaluate("_triggerEvent('foobar')");
+  ASSERT_EQ(0, calls);
+  ASSERT_EQ(1, otherCalls);
+
+  jsEngine->Evaluate("_triggerEvent('foobar'); _triggerEvent('foobar')");
+  ASSERT_EQ(2, calls);
+  ASSERT_EQ(1, otherCalls);
+}
+
 TEST(NewJsEngineTest, CallbackGetSet)
 {
   AdblockPlus::JsEnginePtr jsEngine(AdblockPlus::JsEngine::New());
@@ -134,3 +155,117 @@ TEST(NewJsEngineTest, GlobalPropertyTest)
   ASSERT_EQ(foo->AsString(), "bar");
 }
 
+TEST(NewJsEngineTest, ResourceConstraints)
+{
+  AdblockPlus::ResourceConstraints constraints;
+  constraints.maxSemiSpaceSize = 1;
+  constraints.maxOldSpaceSize = 64;
+  AdblockPlus::JsEnginePtr jsEngine(AdblockPlus::JsEngine::New(
+      AdblockPlus::AppInfo(), constraints));
+  ASSERT_GT(128u * 1024 * 1024, jsEngine->GetStatistics().heapSizeLimit);
+  ASSERT_EQ(2, jsEngine->Evaluate("1 + 1")->AsInt());
+}
+
+
+TEST_F(JsEngineTest, Statistics)
+{
+  AdblockPlus::JsEngineStatistics stats = jsEngine->GetStatistics();
+  ASSERT_LT(0u, stats.usedHeapSize);
+  ASSERT_LE(stats.usedHeapSize, stats.totalHeapSize);
+  ASSERT_LT(0u, stats.heapSizeLimit);
+  ASSERT_EQ(0, stats.pendingTimers);
+  ASSERT_EQ(0, stats.pendingIoThreads);
+
+  const int64_t liveValues = stats.liveValues;
+  {
+    AdblockPlus::JsValuePtr value = jsEngine->NewValue(1);
+    AdblockPlus::JsValue moved(std::move(*jsEngine->NewObject()));
+    ASSERT_EQ(liveValues + 2, jsEngine->GetStatistics().liveValues);
+  }
+  ASSERT_EQ(liveValues, jsEngine->GetStatistics().liveValues);
+
+  jsEngine->Evaluate("setTimeout(function() {}, 100)");
+  ASSERT_EQ(1, jsEngine->GetStatistics().pendingTimers);
+  AdblockPlus::Sleep(200);
+  ASSERT_EQ(0, jsEngine->GetStatistics().pendingTimers);
+
+  const int64_t lockCount = jsEngine->GetStatistics().lockCount;
+  jsEngine->Evaluate("1");
+  stats = jsEngine->GetStatistics();
+  ASSERT_EQ(lockCount + 1, stats.lockCount);
+  // Reading statistics doesn't count as using the engine
+  ASSERT_EQ(stats.lockCount, jsEngine->GetStatistics().lockCount);
+  ASSERT_LE(0, stats.lockWaitTime);
+
+  const int64_t lockHoldTime = stats.lockHoldTime;
+  jsEngine->Evaluate("var end = Date.now() + 20; while (Date.now() < end);");
+  ASSERT_LE(lockHoldTime + 15000, jsEngine->GetStatistics().lockHoldTime);
+}
+
+TEST_F(JsEngineTest, NestedLockingIsNotCounted)
+{
+  const int64_t lockCount = jsEngine->GetStatistics().lockCount;
+  {
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    ASSERT_EQ(2, jsEngine->Evaluate("1 + 1")->AsInt());
+    jsEngine->NewObject()->SetProperty("foo", "bar");
+    ASSERT_EQ(lockCount + 1, jsEngine->GetStatistics().lockCount);
+  }
+}
+
+TEST_F(JsEngineTest, MemoryPressure)
+{
+  // Without a handler, only V8 is notified
+  jsEngine->NotifyMemoryPressure(AdblockPlus::JsEngine::MEMORY_PRESSURE_MODERATE);
+
+  jsEngine->Evaluate("var levels = []; function _onMemoryPressure(level) { levels.push(level); }");
+  jsEngine->NotifyMemoryPressure(AdblockPlus::JsEngine::MEMORY_PRESSURE_MODERATE);
+  jsEngine->NotifyMemoryPressure(AdblockPlus::JsEngine::MEMORY_PRESSURE_CRITICAL);
+  ASSERT_EQ("moderate,critical", jsEngine->Evaluate("levels.join()")->AsString());
+}
+
+TEST_F(JsEngineTest, GcRecordsPauses)
+{
+  const int64_t pauses = jsEngine->GetStatistics().gcPauses.count;
+  jsEngine->Gc();
+  ASSERT_LT(pauses, jsEngine->GetStatistics().gcPauses.count);
+}
+
+TEST_F(JsEngineTest, IdleGc)
+{
+  jsEngine->EnableIdleGc(50, 5);
+  jsEngine->Evaluate("var garbage = []; for (var i = 0; i < 10000; i++) garbage.push({i: i}); garbage = null;");
+  const int64_t pauses = jsEngine->GetStatistics().gcPauses.count;
+  AdblockPlus::Sleep(300);
+  ASSERT_LT(pauses, jsEngine->GetStatistics().gcPauses.count);
+  jsEngine->DisableIdleGc();
+}
+
+TEST_F(JsEngineTest, Scope)
+{
+  AdblockPlus::JsValuePtr value;
+  {
+    const AdblockPlus::JsEngine::Scope scope(jsEngine);
+    value = jsEngine->Evaluate("({foo: 'bar', baz: 12})");
+    {
+      const AdblockPlus::JsEngine::Scope nestedScope(jsEngine);
+      ASSERT_EQ("bar", value->GetProperty("foo")->AsString());
+    }
+    ASSERT_EQ(12, value->GetProperty("baz")->AsInt());
+    ASSERT_ANY_THROW(jsEngine->Evaluate("doesnotexist()"));
+    value->SetProperty("foo", "qux");
+  }
+  ASSERT_EQ("qux", value->GetProperty("foo")->AsString());
+}
+
+TEST(NewJsEngineTest, ScopeKeepsEngineAlive)
+{
+  AdblockPlus::JsEnginePtr jsEngine(AdblockPlus::JsEngine::New());
+  const std::weak_ptr<AdblockPlus::JsEngine> weakJsEngine(jsEngine);
+  std::unique_ptr<AdblockPlus::JsEngine::Scope> scope(
+      new AdblockPlus::JsEngine::Scope(jsEngine));
+  jsEngine.reset();
+  ASSERT_FALSE(weakJsEngine.expired());
+  scope.reset();
+  ASSERT_TRUE(weakJsEngine.expired());
+}
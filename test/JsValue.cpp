@@ -183,6 +183,36 @@ TEST_F(JsValueTest, ArrayValue)
   ASSERT_ANY_THROW(value->Call());
 }
 
+TEST_F(JsValueTest, BulkConversions)
+{
+  AdblockPlus::JsValuePtr value = jsEngine->Evaluate("['foo', 8, '\\u00E4', null]");
+  std::vector<std::string> strings = value->AsStringVector();
+  ASSERT_EQ(4u, strings.size());
+  ASSERT_EQ("foo", strings[0]);
+  ASSERT_EQ("8", strings[1]);
+  ASSERT_EQ("\xC3\xA4", strings[2]);
+  ASSERT_EQ("null", strings[3]);
+
+  value = jsEngine->Evaluate("[5, -8, 1e12, '3']");
+  std::vector<int64_t> ints = value->AsInt64Vector();
+  ASSERT_EQ(4u, ints.size());
+  ASSERT_EQ(5, ints[0]);
+  ASSERT_EQ(-8, ints[1]);
+  ASSERT_EQ(1000000000000LL, ints[2]);
+  ASSERT_EQ(3, ints[3]);
+  ASSERT_EQ(0u, jsEngine->Evaluate("[]")->AsInt64Vector().size());
+
+  value = jsEngine->Evaluate("({foo: 'bar', x: 12})");
+  std::map<std::string, std::string> map = value->AsStringMap();
+  ASSERT_EQ(2u, map.size());
+  ASSERT_EQ("bar", map["foo"]);
+  ASSERT_EQ("12", map["x"]);
+
+  ASSERT_ANY_THROW(value->AsStringVector());
+  ASSERT_ANY_THROW(value->AsInt64Vector());
+  ASSERT_ANY_THROW(jsEngine->NewValue("foo")->AsStringMap());
+}
+
 TEST_F(JsValueTest, FunctionValue)
 {
   AdblockPlus::JsValuePtr value = jsEngine->Evaluate("(function(foo, bar) {return this.x + '/' + foo + '/' + bar;})");
@@ -217,3 +247,61 @@ TEST_F(JsValueTest, ThrowingCoversion)
   ASSERT_EQ("", value->AsString());
   ASSERT_EQ(0, value->AsInt());
 }
+
+TEST_F(JsValueTest, MovedStringProperty)
+{
+  AdblockPlus::JsValuePtr value = jsEngine->NewObject();
+  AdblockPlus::JsValuePtr func = jsEngine->Evaluate(
+      "(function(o) {return o.ascii.length + '/' + o.utf8.length;})");
+
+  std::string ascii(100000, 'x');
+  value->SetProperty("ascii", std::move(ascii));
+  ASSERT_EQ(std::string(100000, 'x'), value->GetProperty("ascii")->AsString());
+
+  std::string utf8;
+  for (int i = 0; i < 10000; i++)
+    utf8 += "\xC3\xA4";
+  value->SetProperty("utf8", std::string(utf8));
+  ASSERT_EQ(utf8, value->GetProperty("utf8")->AsString());
+
+  AdblockPlus::JsValueList params;
+  params.push_back(value);
+  ASSERT_EQ("100000/10000", func->Call(params)->AsString());
+
+  value->SetProperty("short", std::string("foo"));
+  ASSERT_EQ("foo", value->GetProperty("short")->AsString());
+}
+
+TEST_F(JsValueTest, NonAsciiStringConversion)
+{
+  ASSERT_EQ("\xC3\xA4" "bc", jsEngine->Evaluate("'\\u00E4bc'")->AsString());
+  ASSERT_EQ("\xE2\x82\xAC" "bc", jsEngine->Evaluate("'\\u20ACbc'")->AsString());
+  ASSERT_EQ("", jsEngine->Evaluate("''")->AsString());
+}
+
+TEST_F(JsValueTest, RegisteredPropertyNames)
+{
+  static const AdblockPlus::PropertyName fooName("foo");
+  static const AdblockPlus::PropertyName barName("b\xC3\xA4r");
+  ASSERT_NE(fooName.GetIndex(), barName.GetIndex());
+
+  AdblockPlus::JsValuePtr value = jsEngine->Evaluate("({foo: 12})");
+  ASSERT_EQ(12, value->GetProperty(fooName)->AsInt());
+  ASSERT_TRUE(value->GetProperty(barName)->IsUndefined());
+
+  value->SetProperty(fooName, "x");
+  value->SetProperty(barName, true);
+  ASSERT_EQ("x", value->GetProperty("foo")->AsString());
+  ASSERT_TRUE(value->GetProperty("b\xC3\xA4r")->AsBool());
+
+  // Names are registered per process but created per engine
+  AdblockPlus::JsEnginePtr otherEngine = createJsEngine();
+  AdblockPlus::JsValuePtr otherValue = otherEngine->NewObject();
+  otherValue->SetProperty(fooName, 42);
+  ASSERT_EQ(42, otherValue->GetProperty(fooName)->AsInt());
+  ASSERT_EQ("x", value->GetProperty(fooName)->AsString());
+
+  AdblockPlus::JsValuePtr number = jsEngine->NewValue(1);
+  ASSERT_ANY_THROW(number->GetProperty(fooName));
+  ASSERT_ANY_THROW(number->SetProperty(fooName, 1));
+}
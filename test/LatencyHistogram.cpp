@@ -0,0 +1,144 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AdblockPlus.h>
+#include <gtest/gtest.h>
+
+#include "../src/Thread.h"
+
+namespace
+{
+  class RecordThread : public AdblockPlus::Thread
+  {
+  public:
+    explicit RecordThread(AdblockPlus::LatencyHistogram& histogram)
+      : histogram(histogram)
+    {
+    }
+
+    void Run()
+    {
+      for (int i = 1; i <= 1000; i++)
+        histogram.Record(i * 1000);
+    }
+
+  private:
+    AdblockPlus::LatencyHistogram& histogram;
+  };
+
+  int64_t CountBuckets(const AdblockPlus::LatencyStatistics& stats)
+  {
+    int64_t count = 0;
+    for (size_t i = 0; i < stats.buckets.size(); i++)
+      count += stats.buckets[i].second;
+    return count;
+  }
+}
+
+TEST(LatencyHistogramTest, Empty)
+{
+  AdblockPlus::LatencyHistogram histogram;
+  const AdblockPlus::LatencyStatistics stats = histogram.GetStatistics();
+  ASSERT_EQ(0, stats.count);
+  ASSERT_EQ(0, stats.totalTime);
+  ASSERT_EQ(0, stats.maxTime);
+  ASSERT_EQ(0, stats.p50);
+  ASSERT_EQ(0, stats.p999);
+  ASSERT_TRUE(stats.buckets.empty());
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact)
+{
+  AdblockPlus::LatencyHistogram histogram;
+  for (int i = 0; i < 16; i++)
+    histogram.Record(i);
+  const AdblockPlus::LatencyStatistics stats = histogram.GetStatistics();
+  ASSERT_EQ(16, stats.count);
+  ASSERT_EQ(120, stats.totalTime);
+  ASSERT_EQ(15, stats.maxTime);
+  ASSERT_EQ(16u, stats.buckets.size());
+  for (int i = 0; i < 16; i++)
+  {
+    ASSERT_EQ(i, stats.buckets[i].first);
+    ASSERT_EQ(1, stats.buckets[i].second);
+  }
+  ASSERT_EQ(8, stats.p50);
+}
+
+TEST(LatencyHistogramTest, RelativeError)
+{
+  for (int64_t value = 1; value < (static_cast<int64_t>(1) << 35);
+       value = value * 3 + 1)
+  {
+    AdblockPlus::LatencyHistogram histogram;
+    histogram.Record(value);
+    histogram.Record(value + value / 16);
+    const AdblockPlus::LatencyStatistics stats = histogram.GetStatistics();
+    ASSERT_LE(value, stats.buckets.front().first);
+    ASSERT_GE(value + value / 8, stats.buckets.front().first);
+    ASSERT_LE(value, stats.p50);
+    ASSERT_GE(value + value / 8, stats.p50);
+  }
+}
+
+TEST(LatencyHistogramTest, Percentiles)
+{
+  AdblockPlus::LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; i++)
+    histogram.Record(i * 1000);
+  const AdblockPlus::LatencyStatistics stats = histogram.GetStatistics();
+  ASSERT_EQ(1000, stats.count);
+  ASSERT_EQ(500500000, stats.totalTime);
+  ASSERT_EQ(1000000, stats.maxTime);
+  ASSERT_LE(500000, stats.p50);
+  ASSERT_GE(500000 + 500000 / 8, stats.p50);
+  ASSERT_LE(990000, stats.p99);
+  ASSERT_GE(stats.maxTime, stats.p99);
+  ASSERT_EQ(stats.maxTime, stats.p999);
+}
+
+TEST(LatencyHistogramTest, OutOfRangeValuesAreClamped)
+{
+  AdblockPlus::LatencyHistogram histogram;
+  histogram.Record(-1);
+  histogram.Record(INT64_MAX / 2);
+  const AdblockPlus::LatencyStatistics stats = histogram.GetStatistics();
+  ASSERT_EQ(2, stats.count);
+  ASSERT_EQ(0, stats.buckets.front().first);
+  ASSERT_EQ(INT64_MAX / 2, stats.maxTime);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecording)
+{
+  AdblockPlus::LatencyHistogram histogram;
+  std::vector<RecordThread*> threads;
+  for (int i = 0; i < 4; i++)
+    threads.push_back(new RecordThread(histogram));
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i]->Start();
+  for (size_t i = 0; i < threads.size(); i++)
+  {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  const AdblockPlus::LatencyStatistics stats = histogram.GetStatistics();
+  ASSERT_EQ(4000, stats.count);
+  ASSERT_EQ(4000, CountBuckets(stats));
+  ASSERT_EQ(4 * 500500000, stats.totalTime);
+  ASSERT_EQ(1000000, stats.maxTime);
+}
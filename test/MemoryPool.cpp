@@ -0,0 +1,81 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-2015 Eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+#include "../src/MemoryPool.h"
+
+namespace
+{
+  struct Counted
+  {
+    static int instances;
+    int value;
+
+    Counted(int value) : value(value)
+    {
+      instances++;
+    }
+
+    ~Counted()
+    {
+      instances--;
+    }
+  };
+
+  int Counted::instances = 0;
+}
+
+TEST(MemoryPoolTest, BlocksAreReused)
+{
+  AdblockPlus::MemoryPool pool(24);
+  std::vector<void*> live;
+  std::set<void*> seen;
+  for (int i = 0; i < 10000; i++)
+  {
+    void* block = pool.Allocate();
+    ASSERT_TRUE(block);
+    ASSERT_EQ(live.end(), std::find(live.begin(), live.end(), block));
+    live.push_back(block);
+    seen.insert(block);
+    if (live.size() > 100)
+    {
+      pool.Free(live.front());
+      live.erase(live.begin());
+    }
+  }
+  ASSERT_GT(1000u, seen.size());
+}
+
+TEST(MemoryPoolTest, SharedPointers)
+{
+  AdblockPlus::MemoryPool pool(128);
+  std::vector<std::shared_ptr<Counted> > values;
+  for (int i = 0; i < 1000; i++)
+  {
+    values.push_back(std::allocate_shared<Counted>(
+        AdblockPlus::PoolAllocator<Counted>(pool), i));
+  }
+  ASSERT_EQ(1000, Counted::instances);
+  for (int i = 0; i < 1000; i++)
+    ASSERT_EQ(i, values[i]->value);
+  values.clear();
+  ASSERT_EQ(0, Counted::instances);
+}
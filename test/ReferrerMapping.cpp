@@ -84,3 +84,52 @@ TEST(ReferrerMappingTest, CacheOnlyFiveUrls)
   ASSERT_EQ("sixth", referrerChain[4]);
   ASSERT_EQ("seventh", referrerChain[5]);
 }
+
+TEST(ReferrerMappingTest, ReAddedUrlsAreKept)
+{
+  AdblockPlus::ReferrerMapping referrerMapping(3);
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("third", "second");
+  referrerMapping.Add("fourth", "third");
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("fifth", "fourth");
+  std::vector<std::string> referrerChain =
+    referrerMapping.BuildReferrerChain("second");
+  ASSERT_EQ(2u, referrerChain.size());
+  ASSERT_EQ("first", referrerChain[0]);
+  referrerChain = referrerMapping.BuildReferrerChain("fifth");
+  ASSERT_EQ(3u, referrerChain.size());
+  ASSERT_EQ("third", referrerChain[0]);
+}
+
+TEST(ReferrerMappingTest, ChangedReferrer)
+{
+  AdblockPlus::ReferrerMapping referrerMapping;
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("second", "other");
+  std::vector<std::string> referrerChain =
+    referrerMapping.BuildReferrerChain("second");
+  ASSERT_EQ(2u, referrerChain.size());
+  ASSERT_EQ("other", referrerChain[0]);
+}
+
+TEST(ReferrerMappingTest, ByteLimit)
+{
+  // Each mapping takes 20 bytes
+  AdblockPlus::ReferrerMapping referrerMapping(5000, 45);
+  referrerMapping.Add("url0000001", "url0000000");
+  referrerMapping.Add("url0000002", "url0000001");
+  referrerMapping.Add("url0000003", "url0000002");
+  std::vector<std::string> referrerChain =
+    referrerMapping.BuildReferrerChain("url0000003");
+  ASSERT_EQ(3u, referrerChain.size());
+  ASSERT_EQ("url0000001", referrerChain[0]);
+}
+
+TEST(ReferrerMappingTest, ReferrerLoop)
+{
+  AdblockPlus::ReferrerMapping referrerMapping;
+  referrerMapping.Add("first", "second");
+  referrerMapping.Add("second", "first");
+  ASSERT_EQ(11u, referrerMapping.BuildReferrerChain("first").size());
+}